@@ -75,6 +75,9 @@ ENDSEG   = SYSSEG + SYSSIZE 	! where to stop loading
 								! 0x301 - first partition on first drive etc
 								! ļϵͳ豸ڵһӲ̵ĵһϣȵȣ
 ROOT_DEV = 0x306 
+! SWAP_DEV: 0 for no swapping, else the device (eg 0x304) holding the
+! swap-space. It is kept at 506 in the boot sector, like ROOT_DEV.
+SWAP_DEV = 0
 ! 豸0x306ָļϵͳ豸ǵ2Ӳ̵ĵ1Linuxڵ2Ӳϰװ
 ! Linux 0.11ϵͳROOT DI:VΪ0x306ڱںʱԸԼļ
 ! ϵͳ豸λ޸豸š豸!.rouxϵͳʽӲ豸ʽӲ豸
@@ -424,6 +427,9 @@ msg1:						! 
 	.byte 13,10,13,10 		! 24 ASCII ַ
 	
 ! ʾӵַ 508(0x1FC)ʼ root_dev ĵ 508 ʼ 2 ֽС
+.org 506
+swap_dev:
+	.word SWAP_DEV 			! 豸(init/main.c л)0 ʾʹý
 .org 508 					! ʾӵַ508(0x1FC)ʼroot_dev
 							! ĵ508 ʼ2 ֽС
 root_dev:
@@ -17,7 +17,7 @@
 * 뽫ҳĿ¼ǵ
 */
 .text
-.globl _idt,_gdt,_pg_dir,_tmp_floppy_area
+.globl _idt,_gdt,_pg_dir,_tmp_floppy_area,_empty_zero_page
 _pg_dir: 				/* ҳĿ¼	*/
 
 /*
@@ -207,7 +207,16 @@ pg2:
 .org 0x4000
 pg3:
 
-.org 0x5000 	/* ڴݿƫ0x5000 ʼ	*/
+.org 0x5000
+/*
+* empty_zero_page is mapped read-only into processes that read
+* anonymous memory they never wrote (see mm/memory.c). It must stay
+* all zeros.
+*/
+/* ȫҳ棬ֻӳ䵽ȡδдڴĽС	*/
+_empty_zero_page:
+
+.org 0x6000 	/* ڴݿƫ0x6000 ʼ	*/
 /*
 * tmp_floppy_area is used by the floppy-driver when DMA cannot
 * reach to a buffer-block. It needs to be aligned, so that it isn't
@@ -386,7 +395,7 @@ _idt: .fill 256,8,0 				/* idt is uninitialized 256 
 #(0-nul, 1-cs2-ds, 3-syscall, 4-TSS05-LDTO, 6-TSS17-LDT18-TSS2 etc...)
 */
   _gdt: .quad 0x0000000000000000 		/* NULL descriptor */
-	.quad 0x00c09a0000000fff 		/* 16Mb 	 󳤶16M	*/
-	.quad 0x00c0920000000fff 		/* 16Mb 	 ݶ󳤶16M	*/
+	.quad 0x00c09a0000003fff 		/* 64Mb 	 󳤶64M	*/
+	.quad 0x00c0920000003fff 		/* 64Mb 	 ݶ󳤶64M	*/
 	.quad 0x0000000000000000 		/* TEMPORARY - don't use */
 	.fill 252,8,0 					/* space for LDT's and TSS's etc */
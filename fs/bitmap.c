@@ -132,7 +132,7 @@ void free_block(int dev, int block)
 		panic("free_block: bit already cleared");
 	}
 /* Ӧ߼λͼڻ޸ı־	*/
-	sb->s_zmap[block/8192]->b_dirt = 1;
+	mark_buffer_dirty (sb->s_zmap[block/8192]);
 }
 
 /* 豸һ߼飨̿飬飩
@@ -166,7 +166,7 @@ int new_block(int dev)
  * 豸ϵ߼˵ָ߼ڶӦ豸ϲڡʧܣ0˳	*/
 	if (set_bit(j,bh->b_data))
 		panic("new_block: bit already set");
-	bh->b_dirt = 1;
+	mark_buffer_dirty (bh);
 	j += i*8192 + sb->s_firstdatazone-1;
 	if (j >= sb->s_nzones)
 		return 0;
@@ -180,7 +180,7 @@ int new_block(int dev)
 		panic("new block: count is != 1");
 	clear_block(bh->b_data);
 	bh->b_uptodate = 1;
-	bh->b_dirt = 1;
+	mark_buffer_dirty (bh);
 	brelse(bh);
 	return j;
 }
@@ -228,7 +228,7 @@ void free_inode(struct m_inode * inode)
 //Ϣiڵλͼڻ޸ı־ոiڵṹռڴ	*/
 	if (clear_bit(inode->i_num&8191,bh->b_data))
 		printk("free_inode: bit already cleared.\n\r");
-	bh->b_dirt = 1;
+	mark_buffer_dirty (bh);
 	memset(inode,0,sizeof(*inode));
 }
 
@@ -263,7 +263,7 @@ struct m_inode * new_inode(int dev)
  * iڵṹictimeiڵݸıʱ䣩		*/
 	if (set_bit(j,bh->b_data))
 		panic("new_inode: bit already set");
-	bh->b_dirt = 1;
+	mark_buffer_dirty (bh);
 	inode->i_count=1;				/* ü	*/
 	inode->i_nlinks=1;				/* ļĿ¼	*/
 	inode->i_dev=dev;				/* i ڵڵ豸š	*/
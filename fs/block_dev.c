@@ -67,7 +67,7 @@ block_write (int dev, long *pos, char *buf, int count)
 		count -= chars;
 		while (chars-- > 0)
 			*(p++) = get_fs_byte (buf++);
-		bh->b_dirt = 1;
+		mark_buffer_dirty (bh);
 		brelse (bh);
 	}
 	return written;					/* дֽ˳	*/
@@ -38,20 +38,25 @@
 #include <linux/kernel.h>	/* ںͷļһЩں˳úԭζ塣	*/
 #include <asm/system.h>		/* ϵͳͷļû޸/жŵȵǶʽꡣ	*/
 #include <asm/io.h>			/* io ͷļӲ˿/䡣	*/
+#include <asm/segment.h>	/* βͷļйضμĴǶʽຯ	*/
+#include <errno.h>			/* ͷļϵͳиֳš	*/
+#include <sys/bufstat.h>	/* ٻͳϢṹ	*/
 
 /* endɱʱӳIdɣڱں˴ĩˣָںģĩ
  * λãμͼ12-15ҲԴӱںʱɵSystem.mapļв
  * ٻʼں˴ĩλá
- * 33ϵbuffer_waitǵȴл˯ߵͷָ롣뻺ͷ
- * ṹbwaitָòͬһϵͳȱÿл
- * ʱǰͻᱻӵbuffer_wait˯ߵȴСb_waitרŹȴ
- * ָ飨b_waitӦĻ飩ʹõĵȴͷָ롣
+ * 33ϵbuffer_waitǵȴл˯ߵͷ뻺ͷ
+ * ṹbwaitеòͬһϵͳȱÿл
+ * ʱǰͻᱻӵbuffer_wait˯ߵȴУÿͷһֻһ
+ * b_waitרŹȴָ飨b_waitӦĻ飩ʹõĵȴ
+ * ͷʱϵ񶼱ѡ
 */
 extern int end;				/* ӳld ɵıĩ˵ı	*/
 struct buffer_head *start_buffer = (struct buffer_head *) &end;
-struct buffer_head *hash_table[NR_HASH];		/* NR_HASH = 307 	*/
-static struct buffer_head *free_list;			/* лͷָ롣	*/
-static struct task_struct *buffer_wait = NULL;	/* ȴл˯ߵС	*/
+struct buffer_head **hash_table;				/* hash buffer_init()з䡣	*/
+static struct buffer_head *lru_list[NR_LIST] = {NULL, NULL, NULL};	/* lru ͷ	*/
+int nr_buffers_type[NR_LIST] = {0, 0, 0};		/* lru ϵĻ	*/
+static struct wait_queue_head buffer_wait;		/* ȴл˯ߵС	*/
 
 /* 涨ϵͳкеĻNRBUFFERSһlinux/fs.hͷ
  * ļ34еĺֵ꣬Ǳnr_buffersfs.hļ166Ϊȫֱ
@@ -61,6 +66,15 @@ static struct task_struct *buffer_wait = NULL;	/* 
  */
 int NR_BUFFERS = 0;
 
+/* hash (2 )ɢкõλbuffer_init()иݻá	*/
+int NR_HASH = 0;
+static int hash_shift = 32;
+
+/* hash ͳƼͨϵͳbufstat()ȡ	*/
+static unsigned long hash_lookups = 0;
+static unsigned long hash_hits = 0;
+static unsigned long hash_probes = 0;
+
 /* ȴָ	*/
 /* ָĻbhѾý̲жϵ˯ڸûĵȴb_waitС
  * ڻʱȴϵн̽ѡȻڹرжϣcli֮ȥ˯
@@ -76,94 +90,233 @@ static inline void wait_on_buffer (struct buffer_head *bh)
 	sti ();					/* жϡ	*/
 }
 
+/*
+ * Per-device buffer lists. A buffer gets on its device's clean list when
+ * getblk() hands it to the device, moves to the dirty list when it's marked
+ * dirty, and back when sync finds it has been written. Syncing or
+ * invalidating a device thus only looks at the buffers of that device.
+ */
+#define NR_BDEV 32
+
+static struct bdev_buffers bdev_list[NR_BDEV + 1];	/* һ豸á	*/
+
+#define overflow_bdev (bdev_list + NR_BDEV)
+
+/* ȡ豸dev Ļûcreate λһ򣨻ûп
+ * ʱعõһ	*/
+static struct bdev_buffers *
+find_bdev (int dev, int create)
+{
+	struct bdev_buffers *b, *free = NULL;
+
+	for (b = bdev_list; b < overflow_bdev; b++) {
+		if (b->dev == dev)
+			return b;
+		if (!b->dev && !free)
+			free = b;
+	}
+	if (!create || !free)
+		return overflow_bdev;
+	free->dev = dev;
+	return free;
+}
+
+/* ѻڵ豸ժ/޸ı־Ӧ豸ͷ	*/
+static inline void
+unlink_dev_buffer (struct buffer_head *bh, struct bdev_buffers *b)
+{
+	if (bh->b_next_dev)
+		bh->b_next_dev->b_prev_dev = bh->b_prev_dev;
+	if (bh->b_prev_dev)
+		bh->b_prev_dev->b_next_dev = bh->b_next_dev;
+	else if (b->clean == bh)
+		b->clean = bh->b_next_dev;
+	else if (b->dirty == bh)
+		b->dirty = bh->b_next_dev;
+	bh->b_next_dev = bh->b_prev_dev = NULL;
+}
+
+static inline void
+link_dev_buffer (struct buffer_head *bh, struct bdev_buffers *b)
+{
+	struct buffer_head **head = bh->b_dirt ? &b->dirty : &b->clean;
+
+	bh->b_prev_dev = NULL;
+	if ((bh->b_next_dev = *head))
+		(*head)->b_prev_dev = bh;
+	*head = bh;
+}
+
+/* ѻ豸С	*/
+static inline void
+insert_into_dev_list (struct buffer_head *bh)
+{
+	struct bdev_buffers *b = find_bdev (bh->b_dev, 1);
+
+	bh->b_bdev = b;
+	link_dev_buffer (bh, b);
+	b->nr++;
+}
+
+/* ѻ豸Ƴ豸ûлʱͷ	*/
+static inline void
+remove_from_dev_list (struct buffer_head *bh)
+{
+	struct bdev_buffers *b = bh->b_bdev;
+
+	if (!b)
+		return;
+	unlink_dev_buffer (bh, b);
+	bh->b_bdev = NULL;
+	if (!--b->nr && b != overflow_bdev)
+		b->dev = 0;
+}
+
+/* 鵱ǰ޸ı־Ƶ豸Ӧϡ	*/
+static inline void
+refile_dev_buffer (struct buffer_head *bh)
+{
+	if (!bh->b_bdev)
+		return;
+	unlink_dev_buffer (bh, bh->b_bdev);
+	link_dev_buffer (bh, bh->b_bdev);
+}
+
+/*
+ * Write out the dirty buffers of dev found on the lists b (dev 0 means all
+ * of them). Writing sleeps, so the buffers are collected NR_SYNC at a time
+ * and held while we work on them. Buffers on the dirty list that have
+ * been written meanwhile are moved back to the clean list. The number of
+ * passes is capped at what it takes to reach every buffer dirty at the
+ * start: ll_rw_block() may refuse a write and leave b_dirt set, and
+ * writers may keep re-dirtying buffers, and neither must keep us here.
+ */
+#define NR_SYNC 32
+
+/* 豸b 豸dev (0 ʾ豸) ޸Ļд̡	*/
+static void
+sync_dev_list (struct bdev_buffers *b, int dev)
+{
+	struct buffer_head *bh, *next, *list[NR_SYNC];
+	int i, n, passes;
+
+	passes = b->nr / NR_SYNC + 2;
+	do {
+		n = 0;
+		for (bh = b->dirty; bh && n < NR_SYNC; bh = next) {
+			next = bh->b_next_dev;
+			if (dev && bh->b_dev != dev)
+				continue;
+			if (!bh->b_dirt) {
+				if (!bh->b_lock)
+					refile_dev_buffer (bh);
+				continue;
+			}
+			bh->b_count++;
+			list[n++] = bh;
+		}
+		for (i = 0; i < n; i++) {
+			bh = list[i];
+			wait_on_buffer (bh);	/* ȴĻ	*/
+			if (bh->b_dirt) {
+				ll_rw_block (WRITE, bh);/* д豸	*/
+				refile_buffer (bh);
+			}
+			bh->b_count--;
+		}
+	} while (n && --passes);
+}
+
+/* ͬ豸dev (0 ʾ豸) Ļ顣	*/
+static void
+sync_buffers (int dev)
+{
+	struct bdev_buffers *b;
+
+	if (!dev) {
+		for (b = bdev_list; b <= overflow_bdev; b++)
+			if (b->nr)
+				sync_dev_list (b, 0);
+		return;
+	}
+	b = find_bdev (dev, 0);
+	if (b->nr)
+		sync_dev_list (b, dev);
+	if (b != overflow_bdev && overflow_bdev->nr)
+		sync_dev_list (overflow_bdev, dev);
+}
+
 /* 豸ͬ
  * ͬ豸ڴٻݡУsyncinodes()inode.c59С
  */
 int sys_sync (void)
 {
-	int i;
-	struct buffer_head *bh;
-
 /* ȵiڵͬڴiڵ޸ĹiڵдٻСȻ
- * ɨиٻѱ޸ĵĻд󣬽дУ
- * ٻе豸еͬ	*/
+ * ɨ豸޸Ļѱ޸ĵĻд󣬽д
+ * Уٻе豸еͬ	*/
 	sync_inodes ();				/* write out inodes into buffers i ڵдٻ */
-	bh = start_buffer;			/* bhָ򻺳ʼ	*/
-	for (i = 0; i < NR_BUFFERS; i++, bh++)
-	{
-		wait_on_buffer (bh);	/* ȴĻ	*/
-		if (bh->b_dirt)
-		ll_rw_block (WRITE, bh);/* д豸	*/
-	}
+	sync_buffers (0);
 	return 0;
 }
 
 /* ָ豸иٻ豸ݵͬ
- * úٻл顣ָ豸devĻ飬ѱ޸
- * дУͬȻڴiڵдٻС֮ٶָ
- * devִһͬд̲
+ * úȰ豸dev޸ĵĻдУͬȻڴiڵд
+ * ٻС֮ٶָ豸devִһͬд̲
  */
 int
 sync_dev (int dev)
 {
-	int i;
-	struct buffer_head *bh;
-
-/* ȶԲָ豸ִͬ豸ϵٻеͬ
- * ɨٻл飬ָ豸devĻ飬ȼǷѱ
- * ѱ˯ߵȴȻжһθûǷָ豸Ļ鲢
- * ޸Ĺbdirt־λǾͶִд̲Ϊ˯ڼû 
- * пѱͷŻ߱ŲãڼִǰҪٴжһ¸ûǷ
- * ָ豸Ļ飬
- */
-	bh = start_buffer;			/* bhָ򻺳ʼ	*/
-	for (i = 0; i < NR_BUFFERS; i++, bh++)
-	{
-		if (bh->b_dev != dev)	/* 豸devĻ	*/
-			continue;
-		wait_on_buffer (bh);	/* ȴĻ	*/
-		if (bh->b_dev == dev && bh->b_dirt)
-			ll_rw_block (WRITE, bh);
-	}
+	sync_buffers (dev);
 /* ٽiڵдٻ塣iڵinode_tableеinode뻺еϢͬ	*/
 	sync_inodes ();	
 /* Ȼڸٻеݸٰ֮豸еͬͬ
  * ΪںִЧʡһ黺ͬںࡰ顱ɾʹ
  * iڵܹͬЧִСλͬЩiڵֱͬ
  * Ļ豸ͬ	*/
-	bh = start_buffer;
-	for (i = 0; i < NR_BUFFERS; i++, bh++)
-	{
+	sync_buffers (dev);
+	return 0;
+}
+
+/* ʹ豸b 豸dev ĻЧȵȴЩϵI/O ȫÿ
+ * ˯ߺɨ裩˺˯ߣλЧ()־޸ı־	*/
+static void
+invalidate_dev_list (struct bdev_buffers *b, int dev)
+{
+	struct buffer_head *bh, *next;
+
+repeat:
+	for (bh = b->dirty; bh; bh = bh->b_next_dev)
+		if (bh->b_dev == dev && bh->b_lock) {
+			wait_on_buffer (bh);
+			goto repeat;
+		}
+	for (bh = b->clean; bh; bh = bh->b_next_dev)
+		if (bh->b_dev == dev && bh->b_lock) {
+			wait_on_buffer (bh);
+			goto repeat;
+		}
+	for (bh = b->dirty; bh; bh = next) {
+		next = bh->b_next_dev;
 		if (bh->b_dev != dev)
 			continue;
-		wait_on_buffer (bh);
-			if (bh->b_dev == dev && bh->b_dirt)
-				ll_rw_block (WRITE, bh);
-		}
-	return 0;
+		bh->b_uptodate = bh->b_dirt = 0;
+		refile_dev_buffer (bh);
+	}
+	for (bh = b->clean; bh; bh = bh->b_next_dev)
+		if (bh->b_dev == dev)
+			bh->b_uptodate = bh->b_dirt = 0;
 }
 
 /* ʹָ豸ڸٻеЧ	*/
-/* ɨٻел飬ָ豸ĻλЧ()־޸ı־	*/
-void inline
+/* ָ豸Ļ飬λЧ()־޸ı־	*/
+void
 invalidate_buffers (int dev)
 {
-	int i;
-	struct buffer_head *bh;
-
-	bh = start_buffer;
-	for (i = 0; i < NR_BUFFERS; i++, bh++)
-	{
-		if (bh->b_dev != dev)	/* ָ豸Ļ飬	*/
-			continue;			/* ɨһ顣	*/
+	struct bdev_buffers *b = find_bdev (dev, 0);
 
-		wait_on_buffer (bh);	/* ȴûѱ	*/
-
-/* ڽִй˯ߵȴҪжһ»Ƿָ豸ġ	*/
-
-		if (bh->b_dev == dev)
-			bh->b_uptodate = bh->b_dirt = 0;
-	}
+	invalidate_dev_list (b, dev);
+	if (b != overflow_bdev)
+		invalidate_dev_list (overflow_bdev, dev);
 }
 
 /*
@@ -220,18 +373,59 @@ check_disk_change (int dev)
 }
 
 /* дhash (ɢ)hashļꡣ
- * hashҪǼٲұȽԪѵʱ䡣ͨԪصĴ洢λؼ֮
- * һӦϵhashǾͿֱ̲ͨѯָԪء
- * hashָҪǾȷɢеκĸʻȡķ
- * ж֣Linux0.11Ҫ˹ؼֳΪѰҵĻ
- * 豸devͻblockƵhash϶Ҫؼֵ
- * ؼֵֻǼؼֵһַٶԹؼֵMODͿԱ֤
- * õֵںΧڡ
+ * hashҪǼٲұȽԪѵʱ䡣ΪѰҵĻ
+ * 豸devͻblockƵhash϶Ҫؼֵ
+ */
+/*
+ * The hash is multiplicative: dev goes into the high bits, block into the
+ * low ones, and the top bits of the product select the bucket. Unlike the
+ * old (dev^block)%NR_HASH, neighbouring blocks of a file end up spread over
+ * the whole table, so chains stay short even with thousands of buffers.
+ * NR_HASH is a power of two set up by buffer_init().
  */
-#define _hashfn(dev,block) (((unsigned)(dev^block))%NR_HASH)
+#define _hashfn(dev,block) \
+	((((unsigned)(dev) << 20 ^ (unsigned)(block)) * 0x9E370001UL) >> hash_shift)
 #define hash(dev,block) hash_table[_hashfn(dev,block)]
 
-/* hash кͿлָĻ顣	*/
+/*
+ * The lru lists are circular and kept oldest first, so that getblk()
+ * can simply take its victims from the head of the clean list.
+ */
+/* ӻڵlru Ƴû顣	*/
+static inline void
+remove_from_lru_list (struct buffer_head *bh)
+{
+	if (!(bh->b_prev_free) || !(bh->b_next_free))
+		panic ("Free block list corrupted");
+	bh->b_prev_free->b_next_free = bh->b_next_free;
+	bh->b_next_free->b_prev_free = bh->b_prev_free;
+/* ͷָ򱾻ָһǱѿա	*/
+	if (lru_list[bh->b_list] == bh)
+		lru_list[bh->b_list] = bh->b_next_free;
+	if (lru_list[bh->b_list] == bh)
+		lru_list[bh->b_list] = NULL;
+	bh->b_next_free = bh->b_prev_free = NULL;
+	nr_buffers_type[bh->b_list]--;
+}
+
+/* b_list ָlru ĩβ(ʹö)	*/
+static inline void
+insert_into_lru_list (struct buffer_head *bh)
+{
+	struct buffer_head **head = lru_list + bh->b_list;
+
+	if (!*head) {
+		*head = bh;
+		bh->b_prev_free = bh;
+	}
+	bh->b_next_free = *head;
+	bh->b_prev_free = (*head)->b_prev_free;
+	(*head)->b_prev_free->b_next_free = bh;
+	(*head)->b_prev_free = bh;
+	nr_buffers_type[bh->b_list]++;
+}
+
+/* hash кlru ָĻ顣	*/
 
 static inline void
 remove_from_queues (struct buffer_head *bh)
@@ -245,40 +439,303 @@ remove_from_queues (struct buffer_head *bh)
 /* ûǸöеͷһ飬hash ĶӦָ򱾶еһ	*/
 	if (hash (bh->b_dev, bh->b_blocknr) == bh)
 		hash (bh->b_dev, bh->b_blocknr) = bh->b_next;
-/* remove from free list */
-/* ӿлƳ */
-	if (!(bh->b_prev_free) || !(bh->b_next_free))
-		panic ("Free block list corrupted");
-	bh->b_prev_free->b_next_free = bh->b_next_free;
-	bh->b_next_free->b_prev_free = bh->b_prev_free;
-/* ͷָ򱾻ָһ	*/
-	if (free_list == bh)
-		free_list = bh->b_next_free;
+/* remove from lru and device lists */
+	remove_from_lru_list (bh);
+	remove_from_dev_list (bh);
 }
 
-/* ָβhash С	*/
+/* ָlru βhash С	*/
 static inline void insert_into_queues (struct buffer_head *bh)
 {
-/* put at end of free list */
-/* ڿĩβ */
-	bh->b_next_free = free_list;
-	bh->b_prev_free = free_list->b_prev_free;
-	free_list->b_prev_free->b_next_free = bh;
-	free_list->b_prev_free = bh;
+/* put at end of lru list */
+	insert_into_lru_list (bh);
 /* put the buffer in new hash-queue if it has a device */
 /* ûӦһ豸hash*/
-/* ע⵱hashĳ1βʱhash()ֵ϶ΪNULL˴ʱ161
- * õbh>b_next϶NULLԵ163Ӧbh>b_nextΪNULLʱܸ
- * bprevbhֵ163ǰӦжϡif (bh>b_next]ô0.96
- * ű
- */
 	bh->b_prev = NULL;
 	bh->b_next = NULL;
 	if (!bh->b_dev)
 		return;
 	bh->b_next = hash (bh->b_dev, bh->b_blocknr);
 	hash (bh->b_dev, bh->b_blocknr) = bh;
-	bh->b_next->b_prev = bh;			/* ˾ǰӦ if (bh-)bnext) жϡ	*/
+	if (bh->b_next)
+		bh->b_next->b_prev = bh;
+/* and on the lists of its device */
+	insert_into_dev_list (bh);
+}
+
+/*
+ * refile_buffer() puts a buffer at the end of the lru list matching its
+ * current state, which also marks it as the most recently used one.
+ * b_lock can be cleared by an interrupt at any time, so the lists may be
+ * slightly out of date: everybody looking at them has to check the real
+ * flags, and refile what's found to be on the wrong list.
+ */
+/* ݻ鵱ǰ״̬ƵӦlru ĩβ	*/
+void
+refile_buffer (struct buffer_head *bh)
+{
+	remove_from_lru_list (bh);
+	if (bh->b_lock)
+		bh->b_list = BUF_LOCKED;
+	else if (bh->b_dirt)
+		bh->b_list = BUF_DIRTY;
+	else
+		bh->b_list = BUF_CLEAN;
+	insert_into_lru_list (bh);
+}
+
+/*
+ * Start writing out the oldest unused dirty buffers, at most nr (and no
+ * more than NR_FLUSH) of them. The buffers are collected first, as
+ * ll_rw_block() may sleep and change the lists under us, and then sorted
+ * by device and block number so that the requests go out in disk order.
+ * Buffers found clean on the dirty list are refiled as we go. Returns the
+ * oldest buffer written, or NULL if there was nothing we could write.
+ */
+#define NR_FLUSH 64
+
+/* (nr)δʹ໺д̲豸źͿ˳򷢳д
+ * һ顣	*/
+static struct buffer_head *
+write_dirty_buffers (int nr)
+{
+	struct buffer_head *bh, *oldest, *list[NR_FLUSH];
+	int i, j, n = 0;
+
+	if (nr > NR_FLUSH)
+		nr = NR_FLUSH;
+	for (i = nr_buffers_type[BUF_DIRTY]; i-- > 0 && n < nr;) {
+		if (!(bh = lru_list[BUF_DIRTY]))
+			break;
+		if (!bh->b_dirt && !bh->b_lock) {
+			refile_buffer (bh);
+			continue;
+		}
+		lru_list[BUF_DIRTY] = bh->b_next_free;
+		if (bh->b_count || bh->b_lock)
+			continue;
+		bh->b_count++;		/* ʱռãдڼ䱻Ųá	*/
+		list[n++] = bh;
+	}
+	if (!n)
+		return NULL;
+	oldest = list[0];
+/* (豸, )Щв	*/
+	for (i = 1; i < n; i++) {
+		bh = list[i];
+		for (j = i; j > 0; j--) {
+			if (list[j-1]->b_dev < bh->b_dev)
+				break;
+			if (list[j-1]->b_dev == bh->b_dev &&
+			    list[j-1]->b_blocknr < bh->b_blocknr)
+				break;
+			list[j] = list[j-1];
+		}
+		list[j] = bh;
+	}
+	for (i = 0; i < n; i++) {
+		ll_rw_block (WRITE, list[i]);
+		list[i]->b_count--;
+		refile_buffer (list[i]);
+	}
+	return oldest;
+}
+
+/*
+ * bdflush parameters, read and set with sys_bdflush(). The daemon is woken
+ * up every 'interval' ticks, and whenever more than 'nfract' percent of
+ * the buffers are dirty. Each round writes at most 'ndirty' buffers.
+ */
+#define N_PARAM 3
+
+static union bdflush_param {
+	struct {
+		int nfract;		/* bdflush ໺ٷֱȡ	*/
+		int ndirty;		/* ÿһд̵Ļ	*/
+		int interval;	/* ʱѵļ()	*/
+	} b_un;
+	int data[N_PARAM];
+} bdf_prm = {{40, 32, 5 * HZ}};
+
+static int bdflush_min[N_PARAM] = {0, 1, 1};
+static int bdflush_max[N_PARAM] = {100, NR_FLUSH, 60 * HZ};
+
+static struct task_struct *bdflush_task = NULL;	/* bdflush 	*/
+static struct wait_queue_head bdflush_wait;		/* bdflush ڴ˯ߡ	*/
+static int bdflush_timer_pending = 0;
+
+#define too_many_dirty() \
+	(nr_buffers_type[BUF_DIRTY] * 100 > bdf_prm.b_un.nfract * NR_BUFFERS)
+
+/* ʱʱжбãbdflush	*/
+static void
+bdflush_timer (void)
+{
+	bdflush_timer_pending = 0;
+	wake_up (&bdflush_wait);
+}
+
+/*
+ * mark_buffer_dirty() is what everybody should use instead of setting
+ * b_dirt by hand: it puts the buffer on the dirty list, and kicks bdflush
+ * if too much of the cache is dirty.
+ */
+/* û޸ı־Ƶϡ໺bdflush	*/
+void
+mark_buffer_dirty (struct buffer_head *bh)
+{
+	if (bh->b_dirt)
+		return;
+	bh->b_dirt = 1;
+	refile_buffer (bh);
+	refile_dev_buffer (bh);
+	if (too_many_dirty ())
+		wake_up (&bdflush_wait);
+}
+
+/*
+ * Move the buffers whose I/O has completed off the locked list. Returns
+ * the number of buffers that became available for reuse.
+ */
+/* ѾĻBUF_LOCKED ƵӦϡ	*/
+static int
+refile_locked_buffers (void)
+{
+	struct buffer_head *bh;
+	int i, n = 0;
+
+	for (i = nr_buffers_type[BUF_LOCKED]; i-- > 0;) {
+		if (!(bh = lru_list[BUF_LOCKED]))
+			break;
+		if (bh->b_lock) {
+			lru_list[BUF_LOCKED] = bh->b_next_free;
+			continue;
+		}
+		refile_buffer (bh);
+		if (bh->b_list == BUF_CLEAN && !bh->b_count)
+			n++;
+	}
+	return n;
+}
+
+/*
+ * The buffers set up by buffer_init() are only the minimum cache. While
+ * there are pages to spare getblk() grows it with grow_buffers(), four
+ * buffers to a page, and get_free_page() takes pages back through
+ * shrink_buffers() when memory runs low. Buffer heads for these come
+ * from an object cache, so they go back to malloc() along with the
+ * pages once the cache is shrunk.
+ */
+#define BH_CACHE_FREE 64			/* ͷ󻺴ౣĿ	*/
+
+static struct kmem_cache bh_cache;
+
+static inline struct buffer_head *
+get_unused_buffer_head (void)
+{
+	return (struct buffer_head *) kmem_cache_alloc (&bh_cache);
+}
+
+static inline void
+put_unused_buffer_head (struct buffer_head *bh)
+{
+	kmem_cache_free (&bh_cache, bh);
+}
+
+/*
+ * Add a page worth of buffers at the head of the clean list, so that
+ * they're the next ones getblk() hands out. Returns 0 if there was no
+ * memory for them.
+ */
+static int
+grow_buffers (void)
+{
+	struct buffer_head *bh, *first = NULL, *last = NULL;
+	unsigned long page;
+	int i;
+
+	if (!(page = get_free_page_noclear ()))
+		return 0;
+	for (i = 0; i < PAGE_SIZE / BLOCK_SIZE; i++) {
+		if (!(bh = get_unused_buffer_head ())) {
+			while ((bh = first)) {
+				first = bh->b_this_page;
+				put_unused_buffer_head (bh);
+			}
+			free_page (page);
+			return 0;
+		}
+		bh->b_data = (char *) (page + i * BLOCK_SIZE);
+		bh->b_dev = 0;
+		bh->b_blocknr = 0;
+		bh->b_dirt = bh->b_count = bh->b_lock = bh->b_uptodate = 0;
+		bh->b_list = BUF_CLEAN;
+		init_waitqueue_head (&bh->b_wait);
+		bh->b_next = bh->b_prev = NULL;
+		bh->b_next_dev = bh->b_prev_dev = NULL;
+		bh->b_bdev = NULL;
+		bh->b_reqnext = NULL;
+		bh->b_this_page = first;
+		if (!first)
+			last = bh;
+		first = bh;
+	}
+	last->b_this_page = first;
+	bh = first;
+	do {
+		insert_into_lru_list (bh);
+		lru_list[BUF_CLEAN] = bh;
+		NR_BUFFERS++;
+	} while ((bh = bh->b_this_page) != first);
+	return 1;
+}
+
+/*
+ * Free the page of buffers bh belongs to, if none of them is in use,
+ * locked or dirty.
+ */
+static int
+try_to_free_page (struct buffer_head *bh)
+{
+	struct buffer_head *tmp, *next;
+
+	tmp = bh;
+	do {
+		if (tmp->b_count || tmp->b_lock || tmp->b_dirt || waitqueue_active (&tmp->b_wait))
+			return 0;
+	} while ((tmp = tmp->b_this_page) != bh);
+	do {
+		next = tmp->b_this_page;
+		remove_from_queues (tmp);
+		tmp->b_dev = 0;
+		put_unused_buffer_head (tmp);
+		NR_BUFFERS--;
+	} while ((tmp = next) != bh);
+	free_page ((unsigned long) bh->b_data & 0xfffff000);
+	return 1;
+}
+
+/*
+ * Give back up to nr pages of grown buffers, oldest first. Only clean
+ * unused buffers are looked at: dirty ones are left to bdflush. Returns
+ * the number of pages freed.
+ */
+int
+shrink_buffers (int nr)
+{
+	struct buffer_head *bh;
+	int i, freed = 0;
+
+	for (i = nr_buffers_type[BUF_CLEAN]; i-- > 0 && freed < nr;) {
+		if (!(bh = lru_list[BUF_CLEAN]))
+			break;
+		if (bh->b_this_page && try_to_free_page (bh)) {
+			freed++;
+			continue;
+		}
+		lru_list[BUF_CLEAN] = bh->b_next_free;
+	}
+	return freed;
 }
 
 /* hashڸٻѰҸ豸ָŵĻ顣
@@ -289,9 +746,14 @@ static struct buffer_head * find_buffer (int dev, int block)
 	struct buffer_head *tmp;
 
 /* hashѰָ豸źͿŵĻ顣	*/
-	for (tmp = hash (dev, block); tmp != NULL; tmp = tmp->b_next)
-		if (tmp->b_dev == dev && tmp->b_blocknr == block)
+	hash_lookups++;
+	for (tmp = hash (dev, block); tmp != NULL; tmp = tmp->b_next) {
+		hash_probes++;
+		if (tmp->b_dev == dev && tmp->b_blocknr == block) {
+			hash_hits++;
 			return tmp;
+		}
+	}
 	return NULL;
 }
 
@@ -338,113 +800,94 @@ get_hash_table (int dev, int block)
 * race-conditions. Most of the code is seldom used, (ie repeating),
 * so it should be much more efficient than it looks.
 *
-* The algoritm is changed: hopefully better, and an elusive bug removed.
+* The algoritm is changed again: instead of scanning the whole cache
+* for the least "bad" buffer, we take the oldest one from the clean
+* list. Writing dirty buffers is normally left to bdflush: only when
+* nothing clean is left do we write a batch ourselves, and wait for the
+* oldest one.
 */
 /*
 * OKgetblk ú߼ǺͬҲΪҪ
 * ⡣
 * д󲿷ִõ(ظ)Ӧ
 * ȿȥЧöࡣ
-* 㷨Ѿ˸ı䣺ϣܸãһĥĴѾȥ
+* 㷨ٴ˸ı䣺ɨѰҡáĻ飬ֱӴӸɾ
+* ͷȡδʹõһ顣ֻûиɾʱų
+* д̲ȴеһдꡣ
 */
 
-/* 궨ͬʱжϻ޸ı־־Ҷ޸ı־ȨҪ־	*/
-#define BADNESS(bh) (((bh)->b_dirt<<1)+(bh)->b_lock)
-
 /* ȡٻָĻ顣
  * ָ豸źͿţĻǷѾڸٻСָѾڸٻУ
  * 򷵻ضӦͷָ˳ڣҪڸٻһӦ豸źͿŵ
  * Ӧͷָ롣	*/
 struct buffer_head * getblk (int dev, int block)
 {
-	struct buffer_head *tmp, *bh;
+	struct buffer_head *bh;
+	int i;
 
 repeat:
 /* hash ָѾڸٻУ򷵻ضӦͷָ룬˳	*/
 
 	if (bh = get_hash_table (dev, block))
 		return bh;
-/* ɨݿѰҿл	*/
-/* tmp ָĵһлͷ	*/
-
-	tmp = free_list;
-	do
-		{
-/* ûʹãü0ɨһ	*/
-
-			if (tmp->b_count)
-	continue;
-/* ͷָbhΪգtmpָͷı־(޸ġ)ȨСbhͷ־Ȩ
- * أbhָtmpͷtmpͷû޸Ҳû
- * ־λ˵Ϊָ豸ϵĿȡöӦĸٻ飬˳ѭǾͼ
- * ִбѭܷҵһBADNESS0СĻ졣
- */
-
-			if (!bh || BADNESS (tmp) < BADNESS (bh))
-	{
-		bh = tmp;
-		if (!BADNESS (tmp))
+/* Memory to spare: use it for the cache rather than recycle a buffer. */
+	if (nr_free_pages > 2 * min_free_pages)
+		grow_buffers ();
+/* Take the oldest unused buffer off the clean list. Buffers in use are
+ * rotated to the end, and those that have been locked or dirtied since
+ * they were filed are moved to the right list: each is looked at once. */
+/* ӸɾͷʼѰδʹõĻ顣ʹõĻ鱻תĩβ
+ * ޸ĵĻƵӦС	*/
+	for (i = nr_buffers_type[BUF_CLEAN]; i-- > 0; bh = NULL) {
+		if (!(bh = lru_list[BUF_CLEAN]))
 			break;
-	}
-/* and repeat until we find something good	ظֱҵʺϵĻ */
-		}
-	while ((tmp = tmp->b_next_free) != free_list);
-/* ѭ鷢л鶼ڱʹãлͷü>0У˯
- * ȴплáплʱ̻ᱻȷػѡȻǾת
- * ʼ²ҿл顣	*/
-	if (!bh)
-		{
-			sleep_on (&buffer_wait);
-			goto repeat;			/* ת 210 С*/
+		if (bh->b_lock || bh->b_dirt) {
+			refile_buffer (bh);
+			continue;
 		}
-/* ִе˵ѾҵһȽʺϵĿлˡȵȴû
- * (ѱĻ)˯߽׶θûֱʹõĻֻظ
- * Ѱҹ̡	*/
-	wait_on_buffer (bh);
-	if (bh->b_count)				/* ֱռˣ	*/
-		goto repeat;				/* ת 210 С*/
-/* ûѱ޸ģд̣ٴεȴͬأûֱ
- * ʹõĻֻظѰҹ̡	*/
-	while (bh->b_dirt)
-		{
-			sync_dev (bh->b_dev);
+		if (!bh->b_count)
+			break;
+		lru_list[BUF_CLEAN] = bh->b_next_free;
+	}
+/* ûпõĸɾ飬ȿǷѾдĻ飻һ໺
+ * д̲ȴһдꣻҲл鶼ڱʹã˯
+ * ȴплáȻתʼ²ҡ	*/
+	if (!bh) {
+		if (refile_locked_buffers ())
+			goto repeat;
+		if (nr_free_pages > min_free_pages && grow_buffers ())
+			goto repeat;
+		wake_up (&bdflush_wait);
+		if ((bh = write_dirty_buffers (bdf_prm.b_un.ndirty))) {
 			wait_on_buffer (bh);
-			if (bh->b_count)		/* ֱռˣ	*/
-	goto repeat;					/* ת 210 С*/
+			if (!bh->b_lock)
+				refile_buffer (bh);
+			goto repeat;
 		}
-/* NOTE!! While we slept waiting for this block, somebody else might */
-/* already have added "this" block to the cache. check it */
-/* ע⣡Ϊ˵ȴû˯ʱ̿Ѿû 
- * ٻУҪԴ˽м顣
- */
-
-/* ڸٻhash мָ豸ͿĻǷѾȥ
- * ǵĻٴظ̡	*/
-
-		if (find_buffer (dev, block))
+		sleep_on (&buffer_wait);
 		goto repeat;
+	}
 /* OK, FINALLY we know that this buffer is the only one of it's kind, */
 /* and that it's unused (b_count=0), unlocked (b_lock=0), and clean */
 /* OK֪ûָΨһһ飬һûбʹ
- * (b_count=0)δ(b_lock=0)Ǹɾģδ޸ĵģ*/
+ * (b_count=0)δ(b_lock=0)Ǹɾģδ޸ĵģΪӲhash
+ * û˯߹ԲҪټÿǷѱ̼ٻС*/
 /* ռô˻üΪ1λ޸ı־Ч()־	*/
 	bh->b_count = 1;
 	bh->b_dirt = 0;
 	bh->b_uptodate = 0;
-/* hashкͿпƳûͷøûָ豸ϵָ顣
- * Ȼݴµ豸źͿ²hashλôշػ
+/* hashкlru Ƴûͷøûָ豸ϵָ顣
+ * Ȼݴµ豸źͿ²ɾĩβhashλôշػ
  * ͷָ롣	*/
 	remove_from_queues (bh);
 	bh->b_dev = dev;
 	bh->b_blocknr = block;
-/* Ȼݴµ豸źͿ²hash λô	
- * շػͷָ롣	*/
 	insert_into_queues (bh);
 	return bh;
 }
 
 /* ͷָ顣
- * ȴûȻüݼ1ȷػѵȴлĽ̡
+ * ȴûȻüݼ1ʹãһȴлĽ̡
  */
 void
 brelse (struct buffer_head *buf)
@@ -455,7 +898,11 @@ brelse (struct buffer_head *buf)
 	wait_on_buffer (buf);
 	if (!(buf->b_count--))
 		panic ("Trying to free free buffer");
-	wake_up (&buffer_wait);
+	if (!buf->b_count)
+	{
+		refile_buffer (buf);	/* ŵӦlru ĩβ	*/
+		wake_up_one (&buffer_wait);
+	}
 }
 
 /*
@@ -602,6 +1049,30 @@ struct buffer_head * breada (int dev, int first, ...)
 	return (NULL);
 }
 
+/*
+ * bread_ahead() starts reading a block we'll probably want soon, and
+ * doesn't wait for it. Blocks already in the cache (or on their way in)
+ * are left alone, so we don't sleep on them either.
+ */
+/* Ԥָݿ飺ÿ鲻ڸٻУ򷢳Ԥ󣬲ȴ롣	*/
+void
+bread_ahead (int dev, int block)
+{
+	struct buffer_head *bh;
+
+	if (find_buffer (dev, block))
+		return;
+	bh = getblk (dev, block);
+	if (!bh->b_uptodate)
+		ll_rw_block (READA, bh);
+/* let go of it as brelse() does, only without waiting for the read */
+	if (!--bh->b_count)
+	{
+		refile_buffer (bh);
+		wake_up_one (&buffer_wait);
+	}
+}
+
 /* ʼ
  * bufferendǻڴĩˡھ16MBڴϵͳĩ˱Ϊ4MB
  * 8MBڴϵͳĩ˱Ϊ2MBúӻʼλstart_buffer
@@ -609,8 +1080,9 @@ struct buffer_head * breada (int dev, int first, ...)
  * ڴ汻ϡμбǰʾͼ	*/
 void buffer_init (long buffer_end)
 {
-	struct buffer_head *h = start_buffer;
+	struct buffer_head *h;
 	void *b;
+	long size;
 	int i;
 
 /* ȸݲṩĻ߶λȷʵʻ߶λb߶˵1Mb
@@ -620,6 +1092,22 @@ void buffer_init (long buffer_end)
 		b = (void *) (640 * 1024);
 	else
 		b = (void *) buffer_end;
+/* Size the hash table from an estimate of the number of buffers: about
+ * one bucket per two buffers, rounded up to a power of two. As the cache
+ * can grow, half of the free pages are counted as buffers too. The table
+ * itself is taken from the start of the buffer area. */
+/* ݹĻȷhash ĴСԼÿһȡ2 ݣڻ
+ * ʼΪhash ռ䣬ͷṹhash ֮	*/
+	size = (long) b - (long) start_buffer;
+	if (b > (void *) 0x100000)
+		size -= 0x100000 - 0xA0000;
+	size /= BLOCK_SIZE + sizeof (struct buffer_head);
+	size += nr_free_pages * (PAGE_SIZE / BLOCK_SIZE) / 2;
+	for (NR_HASH = 16, hash_shift = 28; NR_HASH < size / 2; NR_HASH <<= 1)
+		hash_shift--;
+	hash_table = (struct buffer_head **) start_buffer;
+	start_buffer = (struct buffer_head *) (hash_table + NR_HASH);
+	h = start_buffer;
 /* δڳʼлѭȡϵͳлĿ
  * Ǵӻ߶˿ʼ1KBСĻ飬ͬʱڻͶ˽û
  * ĽṹbufferheadЩbufferhead˫
@@ -633,9 +1121,15 @@ void buffer_init (long buffer_end)
 			h->b_count = 0;				/* ûü	*/
 			h->b_lock = 0;				/* ־	*/
 			h->b_uptodate = 0;			/* ±־Ч־	*/
-			h->b_wait = NULL;			/* ָȴûĽ̡	*/
+			h->b_list = BUF_CLEAN;		/* ʼʱл鶼ڸɾϡ	*/
+			init_waitqueue_head (&h->b_wait);	/* ȴûĽ̶С	*/
 			h->b_next = NULL;			/* ָͬhash ֵһͷ	*/
 			h->b_prev = NULL;			/* ָͬhash ֵǰһͷ	*/
+			h->b_next_dev = NULL;		/* κ豸	*/
+			h->b_prev_dev = NULL;
+			h->b_bdev = NULL;
+			h->b_reqnext = NULL;
+			h->b_this_page = NULL;
 			h->b_data = (char *) b;		/* ָӦݿ飨1024 ֽڣ	*/
 			h->b_prev_free = h - 1;		/* ָǰһ	*/
 			h->b_next_free = h + 1;		/* ָһ	*/
@@ -646,11 +1140,106 @@ void buffer_init (long buffer_end)
 		}
 	h--;								/* h ָһЧͷ	*/
 
-	free_list = start_buffer;			/* ÿͷָͷһͷ	*/
-	free_list->b_prev_free = h;			/* ͷb_prev_free ָǰһһ	*/
-	h->b_next_free = free_list;			/* h һָָһγһ	*/
+	lru_list[BUF_CLEAN] = start_buffer;	/* øɾͷָͷһͷ	*/
+	start_buffer->b_prev_free = h;		/* ͷb_prev_free ָǰһһ	*/
+	h->b_next_free = start_buffer;		/* h һָָһγһ	*/
+	nr_buffers_type[BUF_CLEAN] = NR_BUFFERS;
 
 /* ʼhash ϣɢбñеָΪNULL	*/
 	for (i = 0; i < NR_HASH; i++)
 		hash_table[i] = NULL;
+	kmem_cache_init (&bh_cache, "buffer_head", sizeof (struct buffer_head),
+			 BH_CACHE_FREE);
+}
+
+/*
+ * sys_bufstat() returns the buffer cache statistics: the number of buffers
+ * on each lru list, the hash chain lengths (counted here, as they change all
+ * the time) and the lookup counters kept by find_buffer().
+ */
+/* ϵͳbufstat()ظٻͳϢ	*/
+int
+sys_bufstat (struct bufstat *buf)
+{
+	struct bufstat tmp;
+	struct buffer_head *bh;
+	int i, len;
+
+	if (!buf)
+		return -EINVAL;
+	tmp.bs_buffers = NR_BUFFERS;
+	tmp.bs_clean = nr_buffers_type[BUF_CLEAN];
+	tmp.bs_locked = nr_buffers_type[BUF_LOCKED];
+	tmp.bs_dirty = nr_buffers_type[BUF_DIRTY];
+	tmp.bs_hash = NR_HASH;
+	tmp.bs_used = tmp.bs_chained = tmp.bs_maxchain = 0;
+	for (i = 0; i < NR_HASH; i++) {
+		for (len = 0, bh = hash_table[i]; bh; bh = bh->b_next)
+			len++;
+		if (len)
+			tmp.bs_used++;
+		tmp.bs_chained += len;
+		if (len > tmp.bs_maxchain)
+			tmp.bs_maxchain = len;
+	}
+	tmp.bs_lookups = hash_lookups;
+	tmp.bs_hits = hash_hits;
+	tmp.bs_probes = hash_probes;
+	verify_area (buf, sizeof *buf);
+	for (i = 0; i < sizeof tmp; i++)
+		put_fs_byte (((char *) &tmp)[i], i + (char *) buf);
+	return 0;
+}
+
+/*
+ * sys_bdflush() is both the entry point of the writeback daemon and the
+ * way to tune it. func 0 turns the caller into the daemon (it returns only
+ * if a signal arrives), func 1 writes out one batch of dirty buffers, and
+ * func >= 2 reads (even) or sets (odd) parameter (func-2)/2.
+ */
+/* ϵͳbdflush()func=0 ʱ߳Ϊдػ̣func=1 ʱдһ໺飻
+ * func>=2 ʱȡ(ż)()(func-2)/2 	*/
+int
+sys_bdflush (int func, long data)
+{
+	int i;
+
+	if (!suser ())
+		return -EPERM;
+	if (func == 1) {
+		write_dirty_buffers (bdf_prm.b_un.ndirty);
+		return 0;
+	}
+	if (func >= 2) {
+		i = (func - 2) >> 1;
+		if (i >= N_PARAM)
+			return -EINVAL;
+		if (!(func & 1)) {
+			verify_area ((void *) data, 4);
+			put_fs_long (bdf_prm.data[i], (unsigned long *) data);
+			return 0;
+		}
+		if (data < bdflush_min[i] || data > bdflush_max[i])
+			return -EINVAL;
+		bdf_prm.data[i] = data;
+		return 0;
+	}
+	if (func)
+		return -EINVAL;
+	if (bdflush_task && bdflush_task != current)
+		return -EBUSY;
+	bdflush_task = current;
+	for (;;) {
+		while (write_dirty_buffers (bdf_prm.b_un.ndirty) && too_many_dirty ())
+			/* nothing */ ;
+		if (!bdflush_timer_pending) {
+			bdflush_timer_pending = 1;
+			add_timer (bdf_prm.b_un.interval, bdflush_timer);
+		}
+		interruptible_sleep_on (&bdflush_wait);
+		if (current->signal & ~current->blocked) {
+			bdflush_task = NULL;
+			return -EINTR;
+		}
+	}
 }
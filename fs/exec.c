@@ -273,7 +273,7 @@ static unsigned long change_ldt (unsigned long text_size, unsigned long *page)
  * ûбҪظȥǣ164166öλַ࣬ʡԡ	*/
 	code_limit = text_size + PAGE_SIZE - 1;
 	code_limit &= 0xFFFFF000;
-	data_limit = 0x4000000;
+	data_limit = TASK_SIZE;
 	code_base = get_base (current->ldt[1]);
 	data_base = code_base;
 	set_base (current->ldt[1], code_base);
@@ -599,8 +599,14 @@ restart_interp:
  * ٸ趨ִʱرļ close_on_execλͼ־رָĴļ
  * λñ־	*/
 	if (current->executable)
+	{
+		unlink_executable (current);
 		iput (current->executable);
+	}
 	current->executable = inode;
+	link_executable (current);
+	current->fault_next = 0;
+	current->fault_win = FAULT_AROUND;
 	for (i = 0; i < 32; i++)
 		current->sigaction[i].sa_handler = NULL;
 	for (i = 0; i < NR_OPEN; i++)
@@ -613,8 +619,15 @@ restart_interp:
  * ΪִļڴҳҳҰִļҳڴС
  * ϴʹЭָǵǰ̣ÿգλʹЭ
  * ı־	*/
-	free_page_tables (get_base (current->ldt[1]), get_limit (0x0f));
-	free_page_tables (get_base (current->ldt[2]), get_limit (0x17));
+/* a vfork() child only gives its parent's memory back */
+	if (current->vfork_dir)
+		release_vfork (current);
+	else
+	{
+		free_page_tables (get_base (current->ldt[1]), get_limit (0x0f));
+		free_page_tables (get_base (current->ldt[2]), get_limit (0x17));
+	}
+	exit_mmap (current);
 	if (last_task_used_math == current)
 		last_task_used_math = NULL;
 	current->used_math = 0;
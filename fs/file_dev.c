@@ -14,6 +14,46 @@
 #define MIN(a,b) (((a)<(b))?(a):(b))	/* ȡa,b еСֵ	*/
 #define MAX(a,b) (((a)>(b))?(a):(b))	/* ȡa,b еֵ	*/
 
+/*
+ * Readahead. A read that starts where the last one left off doubles the
+ * window (up to read_ahead[] of the device), anything else halves it.
+ * The blocks in the window are read with READA, so nobody waits for them;
+ * the window is only topped up when half of it has been used, so that the
+ * requests go out in batches.
+ */
+/* ļԤڣ˳ʱӱ豸Ԥ롣	*/
+static void
+file_ra_adjust (struct m_inode *inode, struct file *filp)
+{
+	int max = read_ahead[MAJOR (inode->i_dev)];
+
+	if (filp->f_pos / BLOCK_SIZE == filp->f_rablock) {
+		filp->f_rawin = filp->f_rawin ? filp->f_rawin << 1 : 2;
+		if (filp->f_rawin > max)
+			filp->f_rawin = max;
+	} else {
+		filp->f_rawin >>= 1;
+		filp->f_raend = 0;
+	}
+}
+
+/* ļпblock ֮Ԥڵݿ鷢Ԥ	*/
+static void
+file_readahead (struct m_inode *inode, struct file *filp, int block)
+{
+	int end, nr;
+
+	if (filp->f_raend <= block)
+		filp->f_raend = block + 1;
+	else if (filp->f_raend - block > filp->f_rawin / 2)
+		return;
+	end = MIN (block + 1 + filp->f_rawin,
+		   (inode->i_size + BLOCK_SIZE - 1) / BLOCK_SIZE);
+	for (; filp->f_raend < end; filp->f_raend++)
+		if ((nr = bmap (inode, filp->f_raend)))
+			bread_ahead (inode->i_dev, nr);
+}
+
 /* ļ - i ڵļṹ豸ݡ
  * i ڵ֪豸ţfilp ṹ֪ļеǰдָλábuf ָ
  * ̬лλãcount ΪҪȡֽ * ֵʵʶȡֽ
@@ -31,9 +71,12 @@ int file_read (struct m_inode *inode, struct file *filp, char *buf, int count)
  * (filp->f_pos)/BLOCK_SIZEڼļǰָݿš	*/
 	if ((left = count) <= 0)
 		return 0;
+	file_ra_adjust (inode, filp);
 	while (left)
 	{
-		if (nr = bmap (inode, (filp->f_pos) / BLOCK_SIZE))
+		if (filp->f_rawin)
+			file_readahead (inode, filp, filp->f_pos / BLOCK_SIZE);
+		if ((nr = bmap (inode, (filp->f_pos) / BLOCK_SIZE)))
 		{
 			if (!(bh = bread (inode->i_dev, nr)))
 				break;
@@ -64,6 +107,7 @@ int file_read (struct m_inode *inode, struct file *filp, char *buf, int count)
 				put_fs_byte (0, buf++);
 		}
 	}
+	filp->f_rablock = filp->f_pos / BLOCK_SIZE;	/* ´˳ӦʼĿ顣	*/
 /* ޸ĸiڵķʱΪǰʱ䡣ضȡֽȡֽΪ0򷵻سš
  * RRENTTIMEǶinclude/linux/sched.h142ϵĺ꣬ڼUNIXʱ䡣
  * 1970110ʱ0뿪ʼǰʱ䡣λ롣	*/
@@ -113,7 +157,7 @@ int file_write (struct m_inode *inode, struct file *filp, char *buf, int count)
  * дֽcount - i˴ֻдc = (count - i)ֽڼɡ	*/
 		c = pos % BLOCK_SIZE;
 		p = c + bh->b_data;
-		bh->b_dirt = 1;
+		mark_buffer_dirty (bh);
 		c = BLOCK_SIZE - c;
 		if (c > count - i)
 			c = count - i;
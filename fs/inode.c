@@ -153,7 +153,7 @@ static int _bmap (struct m_inode *inode, int block, int create)
 			if (i = new_block (inode->i_dev))
 			{
 				((unsigned short *) (bh->b_data))[block] = i;
-				bh->b_dirt = 1;
+				mark_buffer_dirty (bh);
 			}
 /* ͷŸüӿռõĻ飬شԭеĶӦblock߼š	*/
 		brelse (bh);
@@ -188,7 +188,7 @@ static int _bmap (struct m_inode *inode, int block, int create)
 		if (i = new_block (inode->i_dev))
 			{
 				((unsigned short *) (bh->b_data))[block >> 9] = i;
-				bh->b_dirt = 1;
+				mark_buffer_dirty (bh);
 			}
 	brelse (bh);
 /* μӿĶΪ0ʾ̿ʧܻԭӦžΪ0
@@ -206,7 +206,7 @@ static int _bmap (struct m_inode *inode, int block, int create)
 		if (i = new_block (inode->i_dev))
 		{
 			((unsigned short *) (bh->b_data))[block & 511] = i;
-			bh->b_dirt = 1;
+			mark_buffer_dirty (bh);
 		}
 /* ͷŸöμӿĶ飬شĶӦblock ߼Ŀš	*/
 	brelse (bh);
@@ -373,7 +373,7 @@ get_pipe_inode (void)
  * iڵ㣬NULL	*/
 	if (!(inode = get_empty_inode ()))	/* Ҳi ڵ򷵻NULL	*/
 		return NULL;
-	if (!(inode->i_size = get_free_page ()))
+	if (!(inode->i_size = get_free_page_noclear ()))
 	{							/* ڵi_size ֶָ򻺳	*/
 		inode->i_count = 0;		/* ûпڴ棬	*/
 		return NULL;			/* ͷŸi ڵ㣬NULL	*/
@@ -533,7 +533,7 @@ static void write_inode (struct m_inode *inode)
 		[(inode->i_num - 1) % INODES_PER_BLOCK] = *(struct d_inode *) inode;
 /* Ȼû޸ı־iڵѾ뻺еһ£޸ı־㡣Ȼ
  * ͷŸúiڵĻiڵ㡣	*/
-	bh->b_dirt = 1;
+	mark_buffer_dirty (bh);
 	inode->i_dirt = 0;
 	brelse (bh);
 	unlock_inode (inode);
@@ -12,6 +12,7 @@
 							/* һЩйúͻȡǶʽຯ䡣	*/
 
 extern int tty_ioctl (int dev, int cmd, int arg);	/* նioctl(chr_drv/tty_ioctl.c, 115)	*/
+extern int blk_ioctl (int dev, int cmd, int arg);	/* 豸ioctl(blk_drv/ll_rw_blk.c)	*/
 
 /* (ioctl)ָ롣	*/
 typedef int (*ioctl_ptr) (int dev, int cmd, int arg);
@@ -23,8 +24,8 @@ typedef int (*ioctl_ptr) (int dev, int cmd, int arg);
 static ioctl_ptr ioctl_table[] = {
 	NULL,		/* nodev */
 	NULL,		/* /dev/mem */
-	NULL,		/* /dev/fd */
-	NULL,		/* /dev/hd */
+	blk_ioctl,	/* /dev/fd */
+	blk_ioctl,	/* /dev/hd */
 	tty_ioctl,	/* /dev/ttyx */
 	tty_ioctl,	/* /dev/tty */
 	NULL,		/* /dev/lp */
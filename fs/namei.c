@@ -374,7 +374,7 @@ add_entry (struct m_inode *dir,
 			dir->i_mtime = CURRENT_TIME;
 			for (i = 0; i < NAME_LEN; i++)
 				de->name[i] = (i < namelen) ? get_fs_byte (name + i) : 0;
-			bh->b_dirt = 1;
+			mark_buffer_dirty (bh);
 			*res_dir = de;
 			return bh;
 		}
@@ -673,7 +673,7 @@ int open_namei (const char *pathname, int flag, int mode,
 			return -ENOSPC;
 		}
 		de->inode = inode->i_num;
-		bh->b_dirt = 1;
+		mark_buffer_dirty (bh);
 		brelse (bh);
 		iput (dir);
 		*res_inode = inode;
@@ -780,7 +780,7 @@ int sys_mknod (const char *filename, int mode, int dev)
  * εiڵţøٻ޸ı־ŻĿ¼µiڵ㣬ͷŸٻ
  * 󷵻0(ɹ)	*/
 	de->inode = inode->i_num;
-	bh->b_dirt = 1;
+	mark_buffer_dirty (bh);
 	iput (dir);
 	iput (inode);
 	brelse (bh);
@@ -876,7 +876,7 @@ sys_mkdir (const char *pathname, int mode)
 	de->inode = dir->i_num;					/* '..'Ŀ¼	*/
 	strcpy (de->name, "..");
 	inode->i_nlinks = 2;
-	dir_block->b_dirt = 1;
+	mark_buffer_dirty (dir_block);
 	brelse (dir_block);
 	inode->i_mode = I_DIRECTORY | (mode & 0777 & ~current->umask);
 	inode->i_dirt = 1;
@@ -895,7 +895,7 @@ sys_mkdir (const char *pathname, int mode)
 /* Ŀ¼iڵֶεiڵţøٻ޸ı־ŻĿ¼
  * µiڵ㣬ͷŸٻ飬󷵻0 (ɹ)	*/
 	de->inode = inode->i_num;
-	bh->b_dirt = 1;
+	mark_buffer_dirty (bh);
 	dir->i_nlinks++;
 	dir->i_dirt = 1;
 	iput (dir);
@@ -1096,7 +1096,7 @@ sys_rmdir (const char *name)
 	if (inode->i_nlinks != 2)
 		printk ("empty directory has nlink!=2 (%d)", inode->i_nlinks);
 	de->inode = 0;
-	bh->b_dirt = 1;
+	mark_buffer_dirty (bh);
 	brelse (bh);
 	inode->i_nlinks = 0;
 	inode->i_dirt = 1;
@@ -1193,7 +1193,7 @@ sys_unlink (const char *name)
 /* ǿɾļӦĿ¼ˡǽļĿ¼еiڵֶΪ0
  * ʾͷŸĿ¼ðĿ¼Ļ޸ı־ͷŸøٻ顣	*/
 	de->inode = 0;
-	bh->b_dirt = 1;
+	mark_buffer_dirty (bh);
 	brelse (bh);
 /* ȻļӦiڵ1޸ı־¸ıʱΪǰʱ䡣
  * ظiڵĿ¼iڵ㣬0(ɹ)ļһӣiڵ
@@ -1288,7 +1288,7 @@ sys_link (const char *oldname, const char *newname)
 		return -ENOSPC;
 	}
 	de->inode = oldinode->i_num;
-	bh->b_dirt = 1;
+	mark_buffer_dirty (bh);
 	brelse (bh);
 	iput (dir);
 /* ٽԭڵӼ1޸ıʱΪǰʱ䣬iڵ޸ı־
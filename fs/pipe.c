@@ -17,14 +17,17 @@ int read_pipe(struct m_inode * inode, char * buf, int count)
 {
 	int chars, size, read = 0;
 /* Ҫȡֽڼcount0Ǿѭִ²ѭУ
- * ǰܵûݣsize=0ѵȴýڵḶ̌ͨд̡ܵ
+ * ǰܵûݣsize=0ұѶݣѵȴýڵḶ̌ͨ
+ * д̣ܵдֻܵڹܵʱ˯ߣλûݣܵվ˵ж
+ * ̻ѹǣٻѣ
  * ûдܵߣiڵüֵС2򷵻Ѷֽ˳ڸiڵ
  * ˯ߣȴϢPIPESIZEinclude/linux/fs.hС	*/
 	while (count>0)
 	{
 		while (!(size=PIPE_SIZE(*inode)))	/* ȡܵݳֵ	*/
 		{
-			wake_up(&inode->i_wait);
+			if (read)
+				wake_up (&inode->i_wait);
 			if (inode->i_count != 2) /* are there any writers? */
 			return read;
 			sleep_on (&inode->i_wait);
@@ -50,7 +53,8 @@ int read_pipe(struct m_inode * inode, char * buf, int count)
 			put_fs_byte (((char *) inode->i_size)[size++], buf++);
 	}
 /* ˴ζܵѵȴùܵḶ̌ضȡֽ	*/
-	wake_up (&inode->i_wait);
+	if (read)
+		wake_up (&inode->i_wait);
 	return read;
 }
 
@@ -62,8 +66,8 @@ write_pipe (struct m_inode *inode, char *buf, int count)
 	int chars, size, written = 0;
 
 /* Ҫдֽcount0ôǾѭִ²ѭУ
- * ǰܵûѾˣпռsize = 0ѵȴýڵḶ̌ͨ
- * Ƕ̡ܵûжܵߣiڵüֵС2ǰ̷
+ * ǰܵûѾˣпռsize = 0ұдݣѵȴýڵ
+ * Ḷ̌ͨѵǶ̡ܵûжܵߣiڵüֵС2ǰ̷
  * SIGPIPEźţдֽ˳д0ֽڣ򷵻-1õǰ
  * ڸiڵ˯ߣԵȴ̶ܵȡݣӶùܵڳռ䡣PIPESIZEO
  * PIPEHEADOȶļ include/linux/fs.h С	*/
@@ -71,7 +75,8 @@ write_pipe (struct m_inode *inode, char *buf, int count)
 	{
 		while (!(size = (PAGE_SIZE - 1) - PIPE_SIZE (*inode)))
 		{
-			wake_up (&inode->i_wait);
+			if (written)
+				wake_up (&inode->i_wait);
 			if (inode->i_count != 2)
 			{			/* no readers */
 				current->signal |= (1 << (SIGPIPE - 1));
@@ -101,7 +106,8 @@ write_pipe (struct m_inode *inode, char *buf, int count)
 			((char *) inode->i_size)[size++] = get_fs_byte (buf++);
 	}
 /* ˴дܵѵȴܵḶ̌дֽ˳	*/
-	wake_up (&inode->i_wait);
+	if (written)
+		wake_up (&inode->i_wait);
 	return written;
 }
 
@@ -399,7 +399,7 @@ void mount_root (void)
 	{
 		p->s_dev = 0;							/* ʼ	*/
 		p->s_lock = 0;
-		p->s_wait = NULL;
+		init_waitqueue_head (&p->s_wait);
 	}
 /* ϡ⡱ĳʼ֮ǿʼװļϵͳǴӸ豸϶ȡļ
  * ϵͳ飬ȡļϵͳĸiڵ㣨1Žڵ㣩ڴiڵеָ롣
@@ -34,3 +34,18 @@ unsigned char _v; \
 									"1:": "=a" (_v): "d" (port)); \
 									_v; \
 })
+
+/* Ӳ˿˫PCI ÿռDMA ĴҪõ	*/
+/* value - ˫֣	*/
+/* port - ˿ڡ	*/
+#define outl(value,port) \
+__asm__ ( "outl %%eax,%%dx":: "a" (value), "d" (port))
+
+/* Ӳ˿˫뺯	*/
+/* port - ˿ڡ	*/
+/* ضȡ˫֡	*/
+#define inl(port) ({ \
+unsigned long _v; \
+__asm__ volatile ( "inl %%dx,%%eax": "=a" (_v): "d" (port)); \
+_v; \
+})
@@ -18,6 +18,12 @@
 #define sti() __asm__ ( "sti"::)	/* жǶ꺯	*/
 #define cli() __asm__ ( "cli"::)	/* жϡ	*/
 #define nop() __asm__ ( "nop"::)	/* ղ	*/
+
+/* /ָ־Ĵж־ڿڹж״̬µõĴ롣	*/
+#define save_flags(x) \
+__asm__ __volatile__("pushfl ; popl %0":"=r" (x)::"memory")
+#define restore_flags(x) \
+__asm__ __volatile__("pushl %0 ; popfl"::"r" (x):"memory")
 #define iret() __asm__ ( "iret"::)	/* жϷء	*/
 
 /* ꡣ
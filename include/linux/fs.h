@@ -10,6 +10,7 @@
 #define _FS_H
 
 #include <sys/types.h>		/* ͷļ˻ϵͳ͡	*/
+#include <linux/wait.h>		/* ȴͷļȴͷͶṹ	*/
 
 /* devices are as follows: (same as minix, so we can use the minix
 * file system. These are major numbers.)
@@ -60,7 +61,7 @@ void buffer_init (long buffer_end);
 #define NR_INODE	32					/* ϵͳͬʱʹIڵ	*/
 #define NR_FILE		64					/* ϵͳļļ	*/
 #define NR_SUPER	8					/* ϵͳ	*/
-#define NR_HASH		307					/* Hashֵ*/	
+#define NR_HASH nr_hash				/* Hashʼٸı䡣*/
 #define NR_BUFFERS nr_buffers			/* ϵͳʼٸı䡣	*/
 #define BLOCK_SIZE	1024				/* ݿ鳤ȡ	*/
 #define BLOCK_SIZE_BITS 10				/* ݿ鳤ռλ	*/
@@ -95,13 +96,45 @@ struct buffer_head
   unsigned char b_dirt;		/* 0-clean,1-dirty */			/* ޸ı־:0 δ޸,1 ޸	*/
   unsigned char b_count;	/* users using this block */	/* ʹõû	*/
   unsigned char b_lock;		/* 0 - ok, 1 -locked */			/* Ƿ	*/
-  struct task_struct *b_wait;								/* ָȴû	*/
+  unsigned char b_list;		/* lru list we're on */			/* ڵlru (BUF_CLEAN )	*/
+  struct wait_queue_head b_wait;							/* ȴûС	*/
   struct buffer_head *b_prev;	/* hash */					/* ǰһ飨ĸָڻĹ	*/
   struct buffer_head *b_next;	/* hash */					/* һ顣	*/
-  struct buffer_head *b_prev_free;							/* бǰһ顣	*/
-  struct buffer_head *b_next_free;							/* бһ顣	*/
+  struct buffer_head *b_prev_free;	/* lru list */			/* lru ǰһ顣	*/
+  struct buffer_head *b_next_free;	/* lru list */			/* lru һ顣	*/
+  struct buffer_head *b_prev_dev;	/* device list */		/* 豸ǰһ顣	*/
+  struct buffer_head *b_next_dev;	/* device list */		/* 豸һ顣	*/
+  struct bdev_buffers *b_bdev;		/* device lists we're on */	/* 豸Ļ	*/
+  struct buffer_head *b_reqnext;	/* request list */		/* ͬһеһ顣	*/
+  struct buffer_head *b_this_page;	/* circular list of buffers in one page */	/* ͬһҳеĻ飨̬Ļ飩	*/
 };
 
+/*
+ * The buffers of a device are on one of two lists: 'dirty' holds every
+ * dirty buffer of the device (and maybe some that have since been written),
+ * 'clean' holds the rest. Devices share a small table of these; the last
+ * entry is used by all devices that don't find a free one.
+ */
+/* 豸Ļ	*/
+struct bdev_buffers
+{
+  unsigned short dev;				/* 豸ţ0 = 	*/
+  int nr;							/* ϵĻ	*/
+  struct buffer_head *clean;		/* ɾ	*/
+  struct buffer_head *dirty;		/* ޸Ļ	*/
+};
+
+/*
+ * Every buffer is on exactly one of these lists, oldest first. The list
+ * is only a hint: a buffer that gets locked or dirtied is moved to the
+ * right list lazily (see refile_buffer() in fs/buffer.c).
+ */
+/* ڵlru 	*/
+#define BUF_CLEAN	0	/* ɾ(δ޸ġδ)Ļ顣	*/
+#define BUF_LOCKED	1	/* ڽI/O Ļ顣	*/
+#define BUF_DIRTY	2	/* ޸ġδд̵Ļ顣	*/
+#define NR_LIST		3
+
 /* ϵڵ(i ڵ)ݽṹ	*/
 struct d_inode
 {
@@ -126,7 +159,7 @@ struct m_inode
   unsigned char i_nlinks;			/* ļĿ¼	*/
   unsigned short i_zone[9];			/* ֱ(0-6)(7)˫ؼ(8)߼š	*/
 /* these are in memory also */
-  struct task_struct *i_wait;		/* ȴi ڵĽ̡	*/
+  struct wait_queue_head i_wait;	/* ȴi ڵĽ̶С	*/
   unsigned long i_atime;			/* ʱ䡣	*/
   unsigned long i_ctime;			/* i ڵ޸ʱ䡣	*/
   unsigned short i_dev;				/* i ڵڵ豸š	*/
@@ -138,6 +171,8 @@ struct m_inode
   unsigned char i_mount;			/* װ־	*/
   unsigned char i_seek;				/* Ѱ־(lseek ʱ)	*/
   unsigned char i_update;			/* ±־	*/
+  struct task_struct *i_exec;		/* иļĽ	*/
+  struct vm_area *i_mmap;			/* ӳ˸ļӳ	*/
 };
 
 /* ļṹļi ڵ֮佨ϵ	*/
@@ -148,6 +183,9 @@ struct file
   unsigned short f_count;			/* Ӧļļ	*/
   struct m_inode *f_inode;			/* ָӦi ڵ㡣	*/
   off_t f_pos;						/* ļλãдƫֵ	*/
+  unsigned long f_rablock;			/* ˳ʱ´ӦĿ顣	*/
+  unsigned long f_raend;			/* ѷԤĿĩˡ	*/
+  unsigned short f_rawin;			/* ǰԤڣ	*/
 };
 
 /* ڴд̳ṹ	*/
@@ -168,7 +206,7 @@ struct super_block
   struct m_inode *s_isup;			/* װļϵͳĿ¼i ڵ㡣(isup-super i)	*/
   struct m_inode *s_imount;			/* װi ڵ㡣	*/
   unsigned long s_time;				/* ޸ʱ䡣	*/
-  struct task_struct *s_wait;		/* ȴóĽ̡	*/
+  struct wait_queue_head s_wait;	/* ȴóĽ̶С	*/
   unsigned char s_lock;				/* ־	*/
   unsigned char s_rd_only;			/* ֻ־	*/
   unsigned char s_dirt;				/* ޸()־	*/
@@ -199,6 +237,14 @@ extern struct file file_table[NR_FILE];			/* 
 extern struct super_block super_block[NR_SUPER]; /* 飨8 	*/
 extern struct buffer_head *start_buffer;		/* ʼڴλá	*/
 extern int nr_buffers;							/* 	*/
+extern int nr_hash;								/* hash (2 )	*/
+extern int read_ahead[];						/* 豸Ԥ	*/
+
+/* block device ioctls */
+/* 豸ioctl ȡ/Ԥ	*/
+#define BLKRASET	0x1262
+#define BLKRAGET	0x1263
+#define MAX_READAHEAD	64
 
 /* ̲ԭ͡	*/
 /* Ƿı䡣	*/
@@ -241,14 +287,22 @@ extern struct buffer_head *get_hash_table (int dev, int block);
 extern struct buffer_head *getblk (int dev, int block);
 /* /дݿ顣	*/
 extern void ll_rw_block (int rw, struct buffer_head *bh);
+extern void ll_rw_page (int rw, int dev, int page, char *buffer);
 /* ͷָ顣	*/
 extern void brelse (struct buffer_head *buf);
+/* ѻƵ״̬lru ĩβ	*/
+extern void refile_buffer (struct buffer_head *bh);
+/* û޸ı־(Ӧʹֱb_dirt)	*/
+extern void mark_buffer_dirty (struct buffer_head *bh);
 /* ȡָݿ顣	*/
 extern struct buffer_head *bread (int dev, int block);
 /* 4 黺ַָڴС	*/
 extern void bread_page (unsigned long addr, int dev, int b[4]);
 /* ȡͷһָݿ飬ǺҪĿ顣	*/
 extern struct buffer_head *breada (int dev, int block, ...);
+/* ָԤȴ	*/
+extern void bread_ahead (int dev, int block);
+extern int shrink_buffers (int nr);
 /* 豸dev һ̿飨Σ߼飩߼	*/
 extern int new_block (int dev);
 /* ͷ豸е߼(Σ̿)blockλָ߼block ߼λͼλ	*/
@@ -19,6 +19,7 @@
 #define HD_LCYL			0x1f4		/* starting cylinder */
 #define HD_HCYL			0x1f5		/* high byte of starting cyl */
 #define HD_CURRENT		0x1f6		/* 101dhhhh , d=drive, hhhh=head */
+#define HD_LBA			0x40		/* HD_CURRENT: hhhh are LBA bits 24-27 */
 #define HD_STATUS		0x1f7		/* see status-bits */
 #define HD_PRECOMP HD_ERROR			/* same io address, read=error, write=precomp */
 #define HD_COMMAND HD_STATUS		/* same io address, read=status, write=cmd */
@@ -47,6 +48,12 @@
 #define WIN_SEEK		0x70		/* Ѱ	*/
 #define WIN_DIAGNOSE	0x90		/* ϡ	*/
 #define WIN_SPECIFY		0x91		/* 	*/
+#define WIN_MULTREAD	0xC4		/* (ÿжϴһ)	*/
+#define WIN_MULTWRITE	0xC5		/* д	*/
+#define WIN_SETMULT		0xC6		/* öдģʽÿ	*/
+#define WIN_IDENTIFY	0xEC		/* ȡʶϢ	*/
+#define WIN_READDMA		0xC8		/* DMA 	*/
+#define WIN_WRITEDMA	0xCA		/* DMA д	*/
 
 /* Bits for HD_ERROR */
 /* Ĵλĺ壨HD_ERROR */
@@ -70,6 +77,22 @@
 #define ECC_ERR			0x40		/* 	*/
 #define BBD_ERR			0x80		/* 	*/
 
+/*
+ * Bus-master IDE registers (PIIX and compatibles), as offsets from the
+ * I/O base in the controller's PCI BAR4. These are for the primary
+ * channel; the secondary one is 8 ports further up.
+ */
+/* IDE ĴPIIX ݿΪPCI BAR4 ַƫơ	*/
+#define BM_COMMAND		0			/* bit 0 start, bit 3 direction */
+#define BM_STATUS		2			/* see bm-status bits */
+#define BM_PRD			4			/* physical address of PRD table */
+
+#define BM_START		0x01		/* BM_COMMAND: start/stop transfer */
+#define BM_READ			0x08		/* BM_COMMAND: write to memory */
+#define BM_ACTIVE		0x01		/* BM_STATUS: transfer in progress */
+#define BM_ERR			0x02		/* BM_STATUS: error, write 1 to clear */
+#define BM_INTR			0x04		/* BM_STATUS: irq seen, write 1 to clear */
+
 /* Ӳ̷ṹμбϢ	*/
 struct partition
 {
@@ -85,4 +108,49 @@ struct partition
   unsigned int nr_sects;			/* ռõnr of sectors in partition */
 };
 
+/*
+ * The 256 words returned by WIN_IDENTIFY. Only the fields we use have
+ * proper names; the word numbers are given in the comments.
+ */
+/* ʶϢWIN_IDENTIFY ص256 ֣	*/
+struct hd_driveid
+{
+  unsigned short config;			/* 0: lots of obsolete bit flags */
+  unsigned short cyls;				/* 1: "physical" cyls */
+  unsigned short reserved2;			/* 2 */
+  unsigned short heads;				/* 3: "physical" heads */
+  unsigned short track_bytes;		/* 4 */
+  unsigned short sector_bytes;		/* 5 */
+  unsigned short sectors;			/* 6: "physical" sectors per track */
+  unsigned short vendor0[3];		/* 7-9 */
+  unsigned char serial_no[20];		/* 10-19 */
+  unsigned short buf_type;			/* 20 */
+  unsigned short buf_size;			/* 21: 512 byte increments */
+  unsigned short ecc_bytes;			/* 22 */
+  unsigned char fw_rev[8];			/* 23-26 */
+  unsigned char model[40];			/* 27-46 */
+  unsigned char max_multsect;		/* 47: max sectors per READ/WRITE MULTIPLE */
+  unsigned char vendor3;
+  unsigned short dword_io;			/* 48 */
+  unsigned char vendor4;			/* 49 */
+  unsigned char capability;			/* bit 0 DMA, bit 1 LBA */
+  unsigned short reserved50;		/* 50 */
+  unsigned char vendor5;			/* 51 */
+  unsigned char tPIO;
+  unsigned char vendor6;			/* 52 */
+  unsigned char tDMA;
+  unsigned short field_valid;		/* 53 */
+  unsigned short cur_cyls;			/* 54: logical geometry */
+  unsigned short cur_heads;			/* 55 */
+  unsigned short cur_sectors;		/* 56 */
+  unsigned short cur_capacity0;		/* 57 */
+  unsigned short cur_capacity1;		/* 58 */
+  unsigned char multsect;			/* 59: current multiple sector count */
+  unsigned char multsect_valid;
+  unsigned int lba_capacity;		/* 60-61: total number of sectors */
+  unsigned short dma_1word;			/* 62 */
+  unsigned short dma_mword;			/* 63 */
+  unsigned short words64_255[192];
+};
+
 #endif
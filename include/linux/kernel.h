@@ -21,6 +21,33 @@ void free_s (void *obj, int size);
 
 #define free(x) free_s((x), 0)
 
+/*
+ * Named object caches on top of malloc(), for kernel objects that are
+ * allocated and freed often. See lib/malloc.c.
+ */
+/* malloc()֮ϵľ󻺴棬Ƶͷŵں˶	*/
+struct kmem_cache
+{
+	char *name;					/* ơ	*/
+	unsigned int size;			/* С	*/
+	void *freelist;				/* ͷŶ	*/
+	int nr_free;				/* еĶ	*/
+	int max_free;				/* ౣĶ	*/
+	unsigned long hits;			/* ķ	*/
+	unsigned long misses;		/* Ҫmalloc()ķ	*/
+	struct kmem_cache *next;	/* һ档	*/
+};
+
+/* ʼ󻺴档( lib/malloc.c )	*/
+void kmem_cache_init (struct kmem_cache *cachep, char *name,
+					  unsigned int size, int max_free);
+/* Ӷ󻺴з( lib/malloc.c )	*/
+void *kmem_cache_alloc (struct kmem_cache *cachep);
+/* ͷŻض󻺴档( lib/malloc.c )	*/
+void kmem_cache_free (struct kmem_cache *cachep, void *obj);
+/* ڴ治ʱͷŴ洢ͰռõĿҳ档( lib/malloc.c )	*/
+int shrink_malloc (int nr);
+
 /*
 * This is defined as a macro, but at some point this might become a
 * real subroutine that sets a flag if it returns true (to do
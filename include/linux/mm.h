@@ -5,9 +5,105 @@
 
 /* ȡҳ溯ҳַɨҳӳmem_map[]ȡҳ档	*/
 extern unsigned long get_free_page (void);
+/* ͬϣҳ棬ڵԼҳĳϡ	*/
+extern unsigned long get_free_page_noclear (void);
+/* ãһҳ棬ҳ	*/
+extern void zero_free_page (void);
 /* ַָһҳ档ҳĿ¼ҳзָҳϢ	*/
 extern unsigned long put_page (unsigned long page, unsigned long address);
 /* ͷַaddr ʼһҳڴ档޸ҳӳmem_map[]ôϢ	*/
 extern void free_page (unsigned long addr);
+/* ҳ	*/
+extern unsigned long nr_free_pages;
+/* ҳڸʱget_free_page()Ӹٻлҳ档	*/
+extern unsigned long min_free_pages;
+
+/*
+ * do_no_page() reads and maps up to this many pages of an executable
+ * around a fault; the window starts at FAULT_AROUND pages after exec.
+ */
+#define FAULT_AROUND 4
+#define MAX_FAULT_AROUND 16
+
+/* these are not to be changed without changing head.s etc */
+#define LOW_MEM 0x100000					/* ڴͶˣ1MB	*/
+#define TASK_SIZE 0x4000000					/* ÿԵַռ䣨64MB	*/
+#define MAP_NR(addr) (((addr)-LOW_MEM)>>12)	/* ָڴַӳΪҳš	*/
+#define USED 100							/* ҳ汻ռñ־	*/
+
+/*
+ * Every task has a page directory of its own (tss.cr3), so they all
+ * sit at the same linear base, just above the kernel's 64MB identity
+ * mapping. The directory entries below USER_BASE are copied from pg_dir.
+ */
+/* ÿԼҳĿ¼tss.cr3λͬһԻַں
+ * 64MB ӳ֮ϡUSER_BASE µĿ¼pg_dir ƶ	*/
+#define USER_BASE 0x4000000
+#define KERNEL_PDES (USER_BASE >> 22)
+/* ҳĿ¼dir Եַaddr ӦĿ¼ָ롣	*/
+#define pde(dir,addr) ((unsigned long *) (dir) + ((unsigned long) (addr) >> 22))
+
+/* ҳеı־λ	*/
+#define PAGE_PRESENT	0x01
+#define PAGE_RW			0x02
+#define PAGE_USER		0x04
+#define PAGE_ACCESSED	0x20
+#define PAGE_DIRTY		0x40
+
+/* ˢҳ任ٻ꺯
+ * ΪߵַתЧʣCPU ʹõҳݴоƬиٻС޸Ĺҳ
+ * Ϣ֮󣬾Ҫˢ¸ûʹ¼ҳĿ¼ַĴcr3 ķˢ¡
+ * ÿԼҳĿ¼¼صcr3 ǰֵ
+ */
+#define invalidate() \
+__asm__( "movl %%cr3,%%eax\n\tmovl %%eax,%%cr3":::"ax")
+
+/* cr3 ָҳĿ¼dir߻ҪӦcurrent->tss.cr3	*/
+#define load_cr3(dir) \
+__asm__( "movl %%eax,%%cr3":: "a" (dir))
+
+extern unsigned long HIGH_MEMORY;			/* ڴ߶˵ַ	*/
+extern unsigned char * mem_map;				/* ڴҳü	*/
+
+/*
+ * Swapping (mm/swap.c). A page table entry for a page that is out on the
+ * swap device has the present bit clear and the swap page number in the
+ * rest of it, ie (nr << 1).
+ */
+extern int SWAP_DEV;						/* 豸ţ0 ʾûС	*/
+extern void init_swapping (void);
+extern int swap_out (void);
+extern int swap_in (unsigned long *table_ptr);
+extern void swap_free (int swap_nr);
+extern void read_swap_page (int swap_nr, char *buffer);
+extern void write_swap_page (int swap_nr, char *buffer);
+
+/*
+ * Files mapped with mmap() (mm/mmap.c). Each task has NR_MMAP slots,
+ * in logical addresses between MMAP_START and MMAP_END; the brk can't
+ * grow past MMAP_START, and the stack gets what is above MMAP_END.
+ */
+#define NR_MMAP 8
+#define MMAP_START 0x2000000
+#define MMAP_END 0x3800000
+
+struct vm_area
+{
+  unsigned long vm_start, vm_end;	/* ӳ߼ַΧ[start,end)	*/
+  unsigned long vm_offset;		/* vm_start Ӧļƫơ	*/
+  struct m_inode *vm_inode;		/* ӳļi ڵ㣬NULL ʾ	*/
+  int vm_prot;					/* PROT_READ/PROT_WRITE	*/
+  struct task_struct *vm_task;	/* ӳĽ̡	*/
+/* other mappings of the same file, headed by vm_inode->i_mmap */
+  struct vm_area *vm_next_share, *vm_prev_share;
+};
+
+struct task_struct;
+extern struct vm_area *find_vma (struct task_struct *p, unsigned long addr);
+/* ӳ/Ƴļi ڵi_mmap 	*/
+extern void link_mapping (struct vm_area *v, struct task_struct *p);
+extern void unlink_mapping (struct vm_area *v);
+extern void exit_mmap (struct task_struct *p);
+extern void unmap_page_range (unsigned long from, unsigned long size);
 
 #endif
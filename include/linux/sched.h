@@ -1,7 +1,7 @@
 #ifndef _SCHED_H
 #define _SCHED_H
 
-#define NR_TASKS 64			/* ϵͳͬʱ񣨽̣	*/
+#define NR_TASKS 512		/* ϵͳͬʱ񣨽̣	*/
 #define HZ 100				/* ϵͳʱӵδƵ(1 ٺȣÿδ10ms)	*/
 
 #define FIRST_TASK task[0]	/* 0 Ƚ⣬һš	*/
@@ -10,6 +10,7 @@
 #include <linux/head.h>		/* head ͷļ˶ļ򵥽ṹͼѡ	*/
 #include <linux/fs.h>		/* ļϵͳͷļļṹfile,buffer_head,m_inode ȣ	*/
 #include <linux/mm.h>		/* ڴͷļҳСһЩҳͷźԭ͡	*/
+#include <linux/wait.h>		/* ȴͷļȴͷͶṹ	*/
 #include <signal.h>			/* źͷļźŷųźŽṹԼźŲԭ͡	*/
 
 #if (NR_OPEN > 32)
@@ -28,9 +29,13 @@
 #endif
 
 /* ƽ̵ҳĿ¼ҳLinus Ϊںӵĺ֮һ( mm/memory.c, 105 )	*/
-extern int copy_page_tables (unsigned long from, unsigned long to, long size);
+extern int copy_page_tables (unsigned long from, unsigned long to, long size,
+			     unsigned long to_dir);
 /* ͷҳָڴ鼰ҳ( mm/memory.c, 150 )	*/
 extern int free_page_tables (unsigned long from, unsigned long size);
+/* Ϊȡ/ͷһҳĿ¼( mm/memory.c )	*/
+extern unsigned long new_page_dir (void);
+extern void free_page_dir (unsigned long dir);
 
 /* ȳĳʼ( kernel/sched.c, 385 )	*/
 extern void sched_init (void);
@@ -163,6 +168,28 @@ struct task_struct
 	struct m_inode *executable;
 	unsigned long close_on_exec;
 	struct file *filp[NR_OPEN];
+/* demand paging: fault-around window, and where the last one ended */
+	unsigned long fault_next;
+	int fault_win;
+/* other tasks running the same executable, headed by executable->i_exec */
+	struct task_struct *exec_next, *exec_prev;
+/* vfork: our own page directory while we run in the parent's one */
+	unsigned long vfork_dir;
+	struct wait_queue_head vfork_wait;	/* the parent sleeps here meanwhile */
+/* files mapped by mmap() */
+	struct vm_area mmap[NR_MMAP];
+/* run queue links, and the recalculation our counter is up to date with */
+	struct run_queue *rq;
+	struct task_struct *rq_next, *rq_prev;
+	int rq_level;
+	unsigned long rq_epoch;
+/* next task on the list of pending alarms */
+	struct task_struct *alarm_next;
+/* our index in task[], and the next task in our pid hash chain */
+	int nr;
+	struct task_struct *pid_next;
+/* parent, youngest child, younger sibling, older sibling */
+	struct task_struct *p_pptr, *p_cptr, *p_ysptr, *p_osptr;
 /* ldt for this task 0 - zero 1 - cs 2 - ds&ss */
 	struct desc_struct ldt[3];
 /* tss for this task */
@@ -188,6 +215,14 @@ struct task_struct
 	/* math */	0, \
 	/* fs info */	-1,0022,NULL,NULL,NULL,0, \
 	/* filp */	{NULL,}, \
+	/* fault */	0,0, \
+	/* exec */	NULL,NULL, \
+	/* vfork */	0,{NULL,NULL}, \
+	/* mmap */	{{0,0,0,NULL,0},}, \
+	/* rq */	NULL,NULL,NULL,0,0, \
+	/* alarm */	NULL, \
+	/* nr etc */	0,NULL, \
+	/* links */	NULL,NULL,NULL,NULL, \
 	{ \
 		{0,0}, \
 		/* ldt */	{0x9f,0xc0fa00}, \
@@ -215,20 +250,63 @@ extern long startup_time;						/* 
 
 /* Ӷʱʱʱjiffies δʱʱú*fn()( kernel/sched.c,272)	*/
 extern void add_timer (long jiffies, void (*fn) (void));
-/* жϵĵȴ˯ߡ( kernel/sched.c, 151 )	*/
-extern void sleep_on (struct task_struct **p);
-/* жϵĵȴ˯ߡ( kernel/sched.c, 167 )	*/
-extern void interruptible_sleep_on (struct task_struct **p);
-/* ȷ˯ߵĽ̡( kernel/sched.c, 188 )	*/
-extern void wake_up (struct task_struct **p);
+/* Ѷȴβ/ӵȴȡ¡	*/
+extern void add_wait_queue (struct wait_queue_head *q, struct wait_queue *wait);
+extern void remove_wait_queue (struct wait_queue_head *q, struct wait_queue *wait);
+/* жϵĵȴ˯ߡ( kernel/sched.c )	*/
+extern void sleep_on (struct wait_queue_head *q);
+/* жϵĵȴ˯ߡ( kernel/sched.c )	*/
+extern void interruptible_sleep_on (struct wait_queue_head *q);
+/* ȷѵȴ˯ߵĽ̡( kernel/sched.c )	*/
+extern void wake_up (struct wait_queue_head *q);
+/* ֻѵȴϵȴʱһ̡( kernel/sched.c )	*/
+extern void wake_up_one (struct wait_queue_head *q);
+
+extern void wake_up_process (struct task_struct *p);
+extern void signal_wake_up (struct task_struct *p);
+extern void set_alarm (struct task_struct *p, long expires);
+/* ѽ̼/Ƴִļi ڵi_exec 	*/
+extern void link_executable (struct task_struct *p);
+extern void unlink_executable (struct task_struct *p);
+/* vfork()ӽִexecve()˳ʱ黹̵ĵַռ䡣	*/
+extern void release_vfork (struct task_struct *p);
+/* źͽ̺ɢбĹ( kernel/fork.c )	*/
+extern void put_task_nr (int nr);
+extern struct task_struct *find_task_by_pid (int pid);
+extern void unhash_pid (struct task_struct *p);
+
+/*
+ * Keep the parent/child/sibling links of p in order: SET_LINKS makes p
+ * the youngest child of p->p_pptr, REMOVE_LINKS takes it out again.
+ */
+/* άp ĸֵӣSET_LINKS p Ϊp->p_pptr ӽ̣
+ * REMOVE_LINKS ȡ¡	*/
+#define REMOVE_LINKS(p) do { \
+	if ((p)->p_osptr) \
+		(p)->p_osptr->p_ysptr = (p)->p_ysptr; \
+	if ((p)->p_ysptr) \
+		(p)->p_ysptr->p_osptr = (p)->p_osptr; \
+	else \
+		(p)->p_pptr->p_cptr = (p)->p_osptr; \
+	} while (0)
+
+#define SET_LINKS(p) do { \
+	(p)->p_ysptr = NULL; \
+	if (((p)->p_osptr = (p)->p_pptr->p_cptr) != NULL) \
+		(p)->p_osptr->p_ysptr = (p); \
+	(p)->p_pptr->p_cptr = (p); \
+	} while (0)
 
 /*
 * Entry into gdt where to find first TSS. 0-nul, 1-cs, 2-ds, 3-syscall
-* 4-TSS0, 5-LDT0, 6-TSS1 etc ...
+* 4-TSS0, 5-LDT0, 6-TSS1, 7-LDT1. There are only these two TSS/LDT
+* pairs, whatever the number of tasks: schedule() points the one that
+* isn't in use at the task it switches to (see switch_to).
 */
 /*
 * GDTѰҵ1 TSS ȫֱеڡ0-ûnul1-cs2-ݶds3-ϵͳsyscall
-* 4-״̬TSS05-ֲLTD06-״̬TSS1ȡ
+* 4-״̬TSS05-ֲLTD06-״̬TSS17-ֲLDT1ж񣬶ֻ
+* TSS/LDT schedule()õǰδʹõһָҪл񣨲μswitch_to
 */
 /* ӸӢעͿԲ뵽LinusʱϵͳõĴרŷGDTе4ĶС
  * ûǾһֱGDTе4syscallһԡ	*/
@@ -241,24 +319,24 @@ extern void wake_up (struct task_struct **p);
 /* ȫֱе1 ֲ(LDT)ѡš	*/
 #define FIRST_LDT_ENTRY (FIRST_TSS_ENTRY+1)
 
-/* 궨壬ȫֱеn TSS ţѡ	*/
+/* 궨壬ȫֱеn TSS ţѡ	*/
 #define _TSS(n) ((((unsigned long) n)<<4)+(FIRST_TSS_ENTRY<<3))
 
-/* 궨壬ȫֱеn LDT š	*/
+/* 궨壬ȫֱеn LDT š	*/
 #define _LDT(n) ((((unsigned long) n)<<4)+(FIRST_LDT_ENTRY<<3))
 
-/* 궨壬صn Ĵtr	*/
+/* 궨壬õn TSS Ĵtr	*/
 #define ltr(n) __asm__( "ltr %%ax":: "a" (_TSS(n)))
 
-/* 궨壬صn ľֲĴldtr	*/
+/* 궨壬õn LDT ؾֲĴldtr	*/
 #define lldt(n) __asm__( "lldt %%ax":: "a" (_LDT(n)))
 
-/* ȡǰţеֵ̺pid ͬ	*/
-/* أn - ǰš( kernel/traps.c, 79)	*/
+/* ȡǰõTSS/LDT Ժţ0 1޹أ	*/
+/* أn - Ժš	*/
 #define str(n) \
 /* ĴTSS εЧַ>ax	*/	__asm__("str %%ax\n\t" \
 /* (eax - FIRST_TSS_ENTRY*8)>eax	*/		"subl %2,%%eax\n\t" \
-/* (eax/16)>eax = ǰš		*/		"shrl $4,%%eax" \
+/* (eax/16)>eax = Ժš		*/		"shrl $4,%%eax" \
 											:"=a" (n) \
 											:"a" (0),"i" (FIRST_TSS_ENTRY<<3))
 
@@ -266,21 +344,25 @@ extern void wake_up (struct task_struct **p);
 
 
 /*
-* switch_to(n) should switch tasks to task nr n, first
-* checking that n isn't the current task, in which case it does nothing.
+* switch_to(p) should switch tasks to task p, first
+* checking that p isn't the current task, in which case it does nothing.
 * This also clears the TS-flag if the task we switched to has used
-* tha math co-processor latest.
+* tha math co-processor latest. The TSS descriptor of a task sits just
+* below its LDT descriptor, so its selector is tss.ldt-8. The switch
+* also loads cr3 from the TSS, ie the task's own page directory.
 */
 /*
-* switch_to(n)лǰnrnȼn ǵǰ
+* switch_to(p)лǰpȼp ǵǰ
 * ʲôҲ˳лϴУʹùѧ
-* ЭĻ踴λƼĴcr0 еTS ־
+* ЭĻ踴λƼĴcr0 еTS ־TSS 
+* LDT ֮ǰѡΪtss.ldt-8лʱCPU TSS 
+* cr3ԼҳĿ¼
 */
 /* תһTSSѡɵĵַCPUл
  * 룺%0 - TSS ƫƵַ(*&__tmp.a)
  * 		%1 - TSS ѡֵ(*&__tmp.b)
- * 		dx - n ѡ
- * 		ecx - ָtask[n]
+ * 		dx - p TSS ѡ
+ * 		ecx - ָp
  * ʱݽṹtmp齨177Զתfar jumpָĲò4ֽƫ
  * ַ2ֽڵĶѡɡˡtmpaֵ32λƫֵbĵ2ֽTSSε
  * ѡ2ֽڲãתTSSѡлTSSӦĽ̡
@@ -290,12 +372,12 @@ extern void wake_up (struct task_struct **p);
  * lasttaskusedmathеϴʹùЭָбȽ϶ģμļ
  * kernel/sched.c й mathstate__restore()˵
  */
-#define switch_to(n) {\
+#define switch_to(p) {\
 struct {long a,b;} __tmp; \
-/* n ǵǰ?(current ==task[n]?)	*/__asm__("cmpl %%ecx,_current\n\t" \
+/* p ǵǰ?(current ==p?)		*/__asm__("cmpl %%ecx,_current\n\t" \
 /* ǣʲô˳					*/		"je 1f\n\t" \
 /* TSS16λѡ>__tmp.b		*/		"movw %%dx,%1\n\t" \
-/* current = task[n]ecx =л	*/		"xchgl %%ecx,_current\n\t" \
+/* current = pecx =л		*/		"xchgl %%ecx,_current\n\t" \
 /* ִгת*&tmpл		*/		"ljmp %0\n\t" \
 /* лŻִ䡣		*/		\
 /* ԭϴʹùЭ				*/		"cmpl %%ecx,_last_task_used_math\n\t" \
@@ -303,7 +385,7 @@ struct {long a,b;} __tmp; \
 /* ԭϴʹùЭcrOе		*/		"clts\n" \
 /* лл־ TS					*/		"1:" \
 		::"m" (*&__tmp.a),"m" (*&__tmp.b), \
-		"d" (_TSS(n)),"c" ((long) task[n])); \
+		"d" ((p)->tss.ldt-8),"c" ((long) (p))); \
 }
 
 /* ҳַ׼ں˴ûκεط!!	*/
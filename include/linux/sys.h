@@ -90,6 +90,12 @@ extern int sys_symlink();
 extern int sys_lstat();
 extern int sys_readlink();
 extern int sys_uselib();
+extern int sys_bufstat();
+extern int sys_bdflush();
+extern int sys_vfork();
+extern int sys_mmap();
+extern int sys_munmap();
+extern int sys_mallstat();
 
 /*  ϵͳúָϵͳжϴ(int 0x80)Ϊת	*/
 
@@ -108,7 +114,8 @@ fn_ptr sys_call_table[] = { sys_setup, sys_exit, sys_fork, sys_read,
 	sys_setreuid,sys_setregid, sys_sigsuspend, sys_sigpending, sys_sethostname,
 	sys_setrlimit, sys_getrlimit, sys_getrusage, sys_gettimeofday, 
 	sys_settimeofday, sys_getgroups, sys_setgroups, sys_select, sys_symlink,
-	sys_lstat, sys_readlink, sys_uselib };
+	sys_lstat, sys_readlink, sys_uselib, sys_bufstat,
+	sys_bdflush, sys_vfork, sys_mmap, sys_munmap, sys_mallstat };
 
 /* So we don't have to do any more manual updating.... */
 int NR_syscalls = sizeof(sys_call_table)/sizeof(fn_ptr);
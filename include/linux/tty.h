@@ -16,6 +16,7 @@
 #define _TTY_H
 
 #include <termios.h>				/* նͷļҪ첽ͨſڵն˽ӿڡ	*/
+#include <linux/wait.h>				/* ȴͷļȴͷͶṹ	*/
 
 #define TTY_BUF_SIZE 1024			/* tty С	*/
 
@@ -26,7 +27,7 @@ struct tty_queue
 									/* ڴնˣŴж˿ڵַ	*/
   unsigned long head;				/* ͷָ롣	*/
   unsigned long tail;				/* βָ롣	*/
-  struct task_struct *proc_list;	/* ȴб	*/
+  struct wait_queue_head proc_list;	/* ȴ̶Уrs_io.s keyboard.S õƫƣ	*/
   char buf[TTY_BUF_SIZE];			/* еĻ	*/
 };
 
@@ -0,0 +1,38 @@
+/*
+* 'wait.h' defines the wait queues that tasks sleep on until an event
+* (a buffer or inode unlocked, a request freed, pipe or tty data) arrives.
+*/
+/*
+* 'wait.h'˵ȴС˯ߣֱĳ¼i ڵ
+* Сܵնݵȣ
+*/
+#ifndef _WAIT_H
+#define _WAIT_H
+
+struct task_struct;
+
+/*
+* A wait queue entry lives on the stack of the sleeping task for as
+* long as it sleeps. The head keeps the entries in the order they
+* went to sleep, so wake_up_one() wakes the one that has waited longest.
+*/
+/* ȴ˯ں˶ջϣ˯ڼһֱЧͷ˯ߵȺ˳
+* wake_up_one()ѵǵȴʱ	*/
+struct wait_queue
+{
+	struct task_struct *task;		/* ˯ߵ	*/
+	struct wait_queue *next;		/* һ˯ߵ񣩡	*/
+	struct wait_queue *prev;		/* ǰһ	*/
+};
+
+struct wait_queue_head
+{
+	struct wait_queue *first;		/* ˯ߵNULL ʾпա	*/
+	struct wait_queue *last;		/* ˯ߵ	*/
+};
+
+/* ͷ㼴ΪնУ˾̬ʼ	*/
+#define init_waitqueue_head(q) ((q)->first = (q)->last = NULL)
+#define waitqueue_active(q) ((q)->first != NULL)
+
+#endif
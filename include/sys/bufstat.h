@@ -0,0 +1,22 @@
+#ifndef _SYS_BUFSTAT_H
+#define _SYS_BUFSTAT_H
+
+/* ٻͳϢϵͳbufstat()ء	*/
+struct bufstat
+{
+  long bs_buffers;		/* 	*/
+  long bs_clean;		/* ɾϵĻ	*/
+  long bs_locked;		/* ϵĻ	*/
+  long bs_dirty;		/* ϵĻ	*/
+  long bs_hash;			/* hash 	*/
+  long bs_used;			/* ǿյhash 	*/
+  long bs_chained;		/* hash еĻ	*/
+  long bs_maxchain;		/* hash еĳȡ	*/
+  unsigned long bs_lookups;	/* hash Ĵ	*/
+  unsigned long bs_hits;	/* ҵĴ	*/
+  unsigned long bs_probes;	/* ʱȽϹĻ	*/
+};
+
+extern int bufstat (struct bufstat *buf);
+
+#endif
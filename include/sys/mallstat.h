@@ -0,0 +1,20 @@
+#ifndef _SYS_MALLSTAT_H
+#define _SYS_MALLSTAT_H
+
+/* ںڴͳϢϵͳmallstat()ءÿ洢ͰСһ
+ * һ(ms_size Ϊ0)Ͱҳ档	*/
+struct mallstat
+{
+  long ms_size;			/* 洢ͰС	*/
+  long ms_pages;		/* ռõҳ	*/
+  long ms_empty;		/* ûжõҳ	*/
+  long ms_inuse;		/* ʹõĶ	*/
+  unsigned long ms_allocs;	/* 	*/
+  unsigned long ms_frees;	/* ͷŴ	*/
+};
+
+#define NR_MALLSTAT 10		/* 9 洢ͰСҳ	*/
+
+extern int mallstat (struct mallstat *buf, int count);
+
+#endif
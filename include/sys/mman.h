@@ -0,0 +1,29 @@
+#ifndef _SYS_MMAN_H
+#define _SYS_MMAN_H
+
+#include <sys/types.h>
+
+#define PROT_READ	1		/* page can be read */
+#define PROT_WRITE	2		/* page can be written */
+
+#define MAP_SHARED	1		/* share changes (read-only only, for now) */
+#define MAP_PRIVATE	2		/* changes are private */
+#define MAP_FIXED	0x10	/* interpret addr exactly */
+
+/* mmap() takes too many arguments for a register call: they are passed
+ * to the system call in a block. */
+struct mmap_arg
+{
+  void *addr;
+  size_t len;
+  int prot;
+  int flags;
+  int fd;
+  off_t offset;
+};
+
+extern void *mmap (void *addr, size_t len, int prot, int flags, int fd,
+		   off_t offset);
+extern int munmap (void *addr, size_t len);
+
+#endif
@@ -159,6 +159,12 @@
 #define __NR_lstat		84
 #define __NR_readlink	85
 #define __NR_uselib		86
+#define __NR_bufstat	87
+#define __NR_bdflush	88
+#define __NR_vfork		89
+#define __NR_mmap		90
+#define __NR_munmap		91
+#define __NR_mallstat	92
 
 /* ¶ϵͳǶʽ꺯
  * ϵͳú꺯type name(void)
@@ -264,6 +270,7 @@ volatile void exit(int status);
 volatile void _exit(int status);
 int fcntl(int fildes, int cmd, ...);
 int fork(void);
+int vfork(void);
 int getpid(void);
 int getuid(void);
 int geteuid(void);
@@ -51,11 +51,13 @@
  */
 
 static inline _syscall0(int,fork)	
+static inline _syscall0(int,vfork)	/* ӽ̽ø̵ַռ䣬ֱexecve()˳	*/
 
 static inline _syscall0(int,pause)	/* int pause()ϵͳã̵ִͣУֱյһźš	*/
 static inline _syscall1(int,setup,void *,BIOS)	/* int setup(void * BIOS)ϵͳã
 												 * linux ʼбã	*/
 static inline _syscall0(int,sync)	/* int sync()ϵͳãļϵͳ	*/
+static inline _syscall2(int,bdflush,int,func,long,data)	/* ٻдػڡ	*/
 #include <linux/tty.h>				/* tty ͷļйtty_ioͨŷĲ	*/
 #include <linux/sched.h>			/* ȳͷļṹtask_struct1 ʼݡ
 									 * һЩԺʽйúͻȡǶʽຯ	*/
@@ -95,6 +97,7 @@ extern long startup_time;			/* 
 #define EXT_MEM_K (*(unsigned short *)0x90002)
 #define DRIVE_INFO (*(struct drive_info *)0x90080)
 #define ORIG_ROOT_DEV (*(unsigned short *)0x901FC)
+#define ORIG_SWAP_DEV (*(unsigned short *)0x901FA)
 
 /*
  * Yeah, yeah, it's ugly, but I cannot find how to do this correctly
@@ -185,14 +188,15 @@ void main(void)							/* This really IS void, no error here. */
 
 
  	ROOT_DEV = ORIG_ROOT_DEV;
+	SWAP_DEV = ORIG_SWAP_DEV;
  	drive_info = DRIVE_INFO;
 	memory_end = (1<<20) + (EXT_MEM_K<<10);	/* ڴС=1Mb ֽ+չڴ(k)*1024 ֽڡ	*/
 	memory_end &= 0xfffff000;				/* Բ4Kb1 ҳڴ	*/
-	if (memory_end > 16*1024*1024)			/* ڴ泬16Mb16Mb ơ	*/
-		memory_end = 16*1024*1024;
-	if (memory_end > 12*1024*1024) 			/* ڴ>12Mbûĩ=4Mb	*/
-		buffer_memory_end = 4*1024*1024;
-	else if (memory_end > 6*1024*1024)		/* ڴ>6Mbûĩ=2Mb	*/
+	if (memory_end > 64*1024*1024)			/* ڴ泬64Mb64Mb ơ	*/
+		memory_end = 64*1024*1024;			/* (64Mb 1 Եַռ)	*/
+/* This is only the minimum buffer cache: it grows into free pages when
+ * they are there (see grow_buffers() in fs/buffer.c). */
+	if (memory_end > 6*1024*1024)			/* ڴ>6Mbûĩ=2Mb	*/
 		buffer_memory_end = 2*1024*1024;
 	else
 		buffer_memory_end = 1*1024*1024;	/* ûĩ=1Mb	*/
@@ -264,6 +268,12 @@ void init(void)
   										/* ȡӲ̲Ϣ̺Ͱװļϵͳ豸	*/
   										/* ú25 ϵĺ궨ģӦsys_setup()kernel/blk_drv/hd.c,71 С	*/
 	setup((void *) &drive_info);
+/* Start the buffer writeback daemon before anything else gets to dirty
+ * buffers. It has no controlling terminal, and never returns. */
+/* ٻдػ̡ûпնˣء	*/
+	if (!fork())
+		for (;;)
+			bdflush(0,0);
 	(void) open("/dev/tty0",O_RDWR,0);	/* öдʷʽ豸/dev/tty0	*/
  										/* Ӧն˿̨	*/
   										/* صľ0 -- stdin ׼豸	*/
@@ -276,7 +286,7 @@ void init(void)
 /* 180-184 ӽִеݡ	*/
 /* ӽ̹ر˾0(stdin)ֻʽ/etc/rc ļִ/bin/sh 	*/
 /* ֱargv_rc envp_rc μ	*/
-	if (!(pid=fork())) {
+	if (!(pid=vfork())) {
 		close(0);
 		if (open("/etc/rc",O_RDONLY,0))
 			_exit(1);					/* ļʧܣ˳(/lib/_exit.c,10)	*/
@@ -298,7 +308,7 @@ void init(void)
  * ֹУiȻȥγɡѭ
  */
 	while (1) {
-		if ((pid=fork())<0) {
+		if ((pid=vfork())<0) {
 			printf("Fork failed in init\r\n");
 			continue;
 		}
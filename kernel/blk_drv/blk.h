@@ -26,6 +26,10 @@
  * request for paging requests when that is implemented. In
  * paging, 'bh' is NULL, and 'waiting' is used to wait for
  * read/write completion.
+ *
+ * A request may cover several adjacent buffers: they are chained
+ * through b_reqnext, 'bh' being the one currently transferred (to or
+ * from 'buffer'), and 'current_nr_sectors' what is left of it.
  */
 struct request {
 	int dev;						/* -1 if no request 豸š	*/
@@ -33,12 +37,20 @@ struct request {
 	int errors;					/*ʱĴ	*/
 	unsigned long sector;			/* ʼ(1 =2 )	*/
 	unsigned long nr_sectors;		/* /д	*/
+	unsigned long current_nr_sectors;	/* ǰ黹/д	*/
 	char *buffer;					/* ݻ	*/
 	struct task_struct *waiting;	/* ȴִɵĵط	*/
 	struct buffer_head *bh;		/* ͷָ(include/linux/fs.h,68)	*/
+	struct buffer_head *bhtail;	/* һ顣	*/
 	struct request *next;			/* ָһ	*/
 };
 
+/*
+ * Requests for adjacent blocks are merged up to this many sectors
+ * (only for the harddisk, whose driver knows about buffer chains).
+ */
+#define MAX_SECTORS	128				/* ϲһ	*/
+
 /*
  * This is used in the elevator algorithm: Note that
  * reads always go before writes. This is natural: reads
@@ -68,7 +80,7 @@ struct blk_dev_struct
 
 extern struct blk_dev_struct blk_dev[NR_BLK_DEV];	/* 豸飬ÿֿ豸ռһ	*/
 extern struct request request[NR_REQUEST];			/* 顣	*/
-extern struct task_struct *wait_for_request;		/* ȴĽ̶ͷָ롣	*/
+extern struct wait_queue_head wait_for_request;		/* ȴĽ̶С	*/
 
 /* ڿ豸hd.cͷļʱȶ豸豸š
 61һ87оΪļȷĺ궨塣
@@ -144,23 +156,44 @@ extern inline void unlock_buffer(struct buffer_head * bh)
 //ȹرָ豸Ȼ˴ζдǷЧЧݲֵû
 ݸ±־û±־ֵ0ʾ˴Ĳʧ
 ܣʾؿ豸10Ϣ󣬻ѵȴĽԼȴ
-ֵḶ̌ͷŲɾѵǰָָһ
+ֵһ̣ͷŲɾѵǰָָһ
 */
+/*
+ * end_request() finishes the current buffer of the request. If there are
+ * more buffers chained to it, the request stays current and continues with
+ * the next one; otherwise the request is done. A failed buffer has the
+ * rest of its sectors skipped.
+ */
 extern inline void end_request(int uptodate)
 {
-	DEVICE_OFF (CURRENT->dev);			/* ر豸	*/
-	if (CURRENT->bh)
-    {									/* CURRENT Ϊָ豸ŵĵǰṹ	*/
-		CURRENT->bh->b_uptodate = uptodate;/* ø±־	*/
-		unlock_buffer (CURRENT->bh);		/* 	*/
-    }
+	struct buffer_head * bh;
+
 	if (!uptodate)
     {									/* ±־Ϊ0 ʾ豸Ϣ	*/
 		printk (DEVICE_NAME " I/O error\n\r");
-		printk ("dev %04x, block %d\n\r", CURRENT->dev, CURRENT->bh->b_blocknr);
+		printk ("dev %04x, sector %d\n\r", CURRENT->dev, CURRENT->sector);
+		CURRENT->sector += CURRENT->current_nr_sectors;	/* ûµ	*/
+		CURRENT->nr_sectors -= CURRENT->current_nr_sectors;
     }
-	wake_up (&CURRENT->waiting);			/* ѵȴĽ̡	*/
-	wake_up (&wait_for_request);			/* ѵȴĽ̡	*/
+	if ((bh = CURRENT->bh))
+    {									/* CURRENT Ϊָ豸ŵĵǰṹ	*/
+		CURRENT->bh = bh->b_reqnext;
+		bh->b_reqnext = NULL;
+		bh->b_uptodate = uptodate;		/* ø±־	*/
+		unlock_buffer (bh);				/* 	*/
+		if ((bh = CURRENT->bh))
+	{									/* лл飬Ŵһ顣	*/
+		CURRENT->current_nr_sectors = BLOCK_SIZE >> 9;
+		CURRENT->buffer = bh->b_data;
+		CURRENT->errors = 0;
+		if (CURRENT->nr_sectors < CURRENT->current_nr_sectors)
+			panic (DEVICE_NAME ": buffer list destroyed");
+		return;
+	}
+    }
+	DEVICE_OFF (CURRENT->dev);			/* ر豸	*/
+	wake_up_process (CURRENT->waiting);	/* ѵȴĽ̡	*/
+	wake_up_one (&wait_for_request);		/* ͷһһȴĽ̡	*/
 	CURRENT->dev = -1;					/* ͷŸ	*/
 	CURRENT = CURRENT->next;				/* ɾ	*/
 }										/*ǰָָһ	*/
@@ -50,9 +50,16 @@ inb_p(0x71); \
 /* У
 * λʱӲжϴеõУ(287)*/
 static void recal_intr (void);
+static int controller_ready (void);
 
 static int recalibrate = 1;	/* У־˸ñ־лrecalintrOԽͷƶ0档	*/
 static int reset = 1;		/* λ־дʱøñ־ظλԸλӲ̺Ϳ	*/
+static int setmult = 0;		/* drives (bitmap) needing SET MULTIPLE */
+static int cur_mult = 1;		/* sectors per interrupt for CURRENT */
+static struct request wreq;		/* write cursor, runs ahead of CURRENT */
+static int dma_drives = 0;		/* drives (bitmap) doing bus-master DMA */
+static int lba_drives = 0;		/* drives (bitmap) addressed by LBA28 */
+static unsigned long hd_dma_base = 0;	/* bus-master I/O base, 0 = none */
 
 /*
  *  This struct defines the HD's and their types.
@@ -65,6 +72,7 @@ static int reset = 1;		/* 
 struct hd_i_struct
 {
 	int head,sect,cyl,wpcom,lzone,ctl;
+	int mult;			/* sectors per READ/WRITE MULTIPLE, 0 = don't use it */
 };
 /* Ѿinclude/linux/config.hļж˷ųHD_TYPEȡж
 * õĲΪӲϢhd_info[]еݡĬ϶Ϊ0ֵsetup()
@@ -74,7 +82,7 @@ struct hd_i_struct
 struct hd_i_struct hd_info[] = { HD_TYPE };	/* ӲϢ顣	*/
 #define NR_HD ((sizeof (hd_info))/(sizeof (struct hd_i_struct)))/* Ӳ	*/
 #else										/* 򣬶Ϊ0 ֵ	*/
-struct hd_i_struct hd_info[] = { {0,0,0,0,0,0},{0,0,0,0,0,0} };
+struct hd_i_struct hd_info[] = { {0,0,0,0,0,0,0},{0,0,0,0,0,0,0} };
 static int NR_HD = 0;
 #endif
 
@@ -95,6 +103,114 @@ __asm__("cld;rep;insw"::"d" (port),"D" (buf),"c" (nr):"cx","di")
 #define port_write(port,buf,nr) \
 __asm__("cld;rep;outsw"::"d" (port),"S" (buf),"c" (nr):"cx","si")
 
+/*
+ * hd_identify() asks the drive for its IDENTIFY block, with interrupts
+ * disabled at the controller (nIEN) so that it can simply be polled.
+ * All we want from it is the largest READ/WRITE MULTIPLE block size:
+ * mult is left 0 for drives that don't answer or don't support it.
+ */
+static struct hd_driveid hd_id[MAX_HD];
+
+static void hd_identify(int drive)
+{
+	int i, mult;
+
+	hd_info[drive].mult = 0;
+	outb_p(hd_info[drive].ctl|2,HD_CMD);
+	outb_p(0xA0|(drive<<4),HD_CURRENT);
+	if (!controller_ready())
+		goto out;
+	outb(WIN_IDENTIFY,HD_COMMAND);
+	for (i=0 ; i<100000 && (inb_p(HD_STATUS)&BUSY_STAT) ; i++)
+		/* nothing */ ;
+	if ((inb_p(HD_STATUS)&(BUSY_STAT|DRQ_STAT|ERR_STAT)) != DRQ_STAT)
+		goto out;
+	port_read(HD_DATA,&hd_id[drive],256);
+	for (mult = 16 ; mult > hd_id[drive].max_multsect ; mult >>= 1)
+		/* nothing */ ;
+	if (mult > 1)
+		hd_info[drive].mult = mult;
+out:
+	outb_p(hd_info[drive].ctl,HD_CMD);
+}
+
+/*
+ * Bus-master DMA. A PRD (physical region descriptor) table lists the
+ * memory areas of a transfer: each entry may not cross a 64kB
+ * boundary, and the table itself lives in a page of its own so that
+ * it doesn't either. Kernel memory is identity mapped, so buffer
+ * addresses can be handed to the controller as they are.
+ */
+struct hd_prd {
+	unsigned long addr;
+	unsigned long count;		/* bytes, PRD_EOT marks the last entry */
+};
+
+/* A request never holds more buffers than this, nor needs more entries. */
+#define NR_PRD (MAX_SECTORS/2)
+#define PRD_EOT 0x80000000
+
+#if NR_PRD * 8 > 4096
+#error "hd: PRD table no longer fits in a page, lower MAX_SECTORS"
+#endif
+
+static struct hd_prd * prd_table = NULL;
+
+#define PCI_CONF(bus,dev,fn,reg) \
+	(0x80000000|((bus)<<16)|((dev)<<11)|((fn)<<8)|((reg)&0xfc))
+
+static unsigned long pci_read(int dev,int fn,int reg)
+{
+	outl(PCI_CONF(0,dev,fn,reg),0xCF8);
+	return inl(0xCFC);
+}
+
+static void pci_write(int dev,int fn,int reg,unsigned long val)
+{
+	outl(PCI_CONF(0,dev,fn,reg),0xCF8);
+	outl(val,0xCFC);
+}
+
+/*
+ * Look for a PCI IDE controller (class 0x0101) on bus 0 whose primary
+ * channel is in compatibility mode, ie it is the 0x1f0 one we drive.
+ * If there is one, turn on bus mastering and use DMA for every drive
+ * whose IDENTIFY data says it can do it. Otherwise nothing changes
+ * and all transfers stay PIO.
+ */
+static void hd_dma_init(void)
+{
+	int dev,fn,drive;
+	unsigned long class,base;
+
+	for (dev=0 ; dev<32 ; dev++)
+		for (fn=0 ; fn<8 ; fn++) {
+			if ((pci_read(dev,fn,0x00) & 0xffff) == 0xffff)
+				continue;
+			class = pci_read(dev,fn,0x08) >> 8;
+			if ((class >> 8) != 0x0101 || (class & 0x01))
+				continue;
+			base = pci_read(dev,fn,0x20);
+			if (!(base & 1) || !(base &= 0xfffc))
+				continue;
+			pci_write(dev,fn,0x04,pci_read(dev,fn,0x04) | 0x05);
+			goto found;
+		}
+	return;
+found:
+	for (drive=0 ; drive<NR_HD ; drive++)
+		if (hd_id[drive].capability & 0x01)
+			dma_drives |= 1<<drive;
+	if (!dma_drives)
+		return;
+	if (!(prd_table = (struct hd_prd *) get_free_page())) {
+		dma_drives = 0;
+		return;
+	}
+	hd_dma_base = base;
+	printk("hd: bus-master DMA at 0x%04x\n\r",base);
+}
+
 extern void hd_interrupt(void);	/* ӲжϹ̣system_call.s221 У	*/
 extern void rd_load(void);		/* ̴غramdisk.c71 У	*/
 
@@ -201,6 +317,19 @@ int sys_setup(void * BIOS)
 		hd[i*5].start_sect = 0;
 		hd[i*5].nr_sects = 0;
 	}
+	for (drive=0 ; drive<NR_HD ; drive++) {
+		hd_identify(drive);
+		if ((hd_id[drive].capability & 0x02) && hd_id[drive].lba_capacity) {
+			lba_drives |= 1<<drive;
+			hd[drive*5].nr_sects = hd_id[drive].lba_capacity;
+			printk("hd%c: LBA, %d sectors\n\r",'a'+drive,
+				hd[drive*5].nr_sects);
+		}
+		if (hd_info[drive].mult)
+			printk("hd%c: using %d-sector multiple mode\n\r",
+				'a'+drive,hd_info[drive].mult);
+	}
+	hd_dma_init();
 /* ãΪֹѾȷϵͳӲ̸NRHDȡÿӲ
 ϵ1еķϢ÷ṹhd[]Ӳ̸Ϣ
 ö麯bread()Ӳ̵1ݿ飨fs/buffer.c,267У10x300
@@ -238,6 +367,7 @@ II
 	if (NR_HD)
 		printk("Partition table%s ok.\n\r",(NR_HD>1)?"s":"");
 	rd_load();				/* Դ̡(kernel/blk_drv/ramdisk.c,71)	*/
+	init_swapping();
 	mount_root();			/* װļϵͳ(fs/super.c,242)	*/
 	return (0);
 }
@@ -294,7 +424,7 @@ static void hd_out(unsigned int drive,unsigned int nsect,unsigned int sect,
 * Ӳ̿Ҳͣ
 */
 
-	if (drive>1 || head>15)						/* (0,1)>1 ͷ>15֧֡	*/
+	if (drive>1 || (head & ~(HD_LBA|0x0f)))		/* (0,1)>1 ͷ>15֧֡	*/
 		panic("Trying to write bad sector");
 	if (!controller_ready())					/* ȴһʱδ	*/
 		panic("HD controller not ready");
@@ -396,6 +526,8 @@ static void bad_rw_intr(void)
 */
 static void read_intr(void)
 {
+	int i, n;
+
 /* úжϴ˴ζǷæ״̬
 ִдӲ̲ʧ⣬ٴӲλִ
 Ȼ󷵻ءÿζԵǰۼƣ
@@ -416,19 +548,53 @@ static void read_intr(void)
 ʱὫúָÿաμsystem_call.s237238С
 */
 
-	port_read(HD_DATA,CURRENT->buffer,256);		/* ݴݼĴڶṹ	*/
-	CURRENT->errors = 0;						/* 	*/
-	CURRENT->buffer += 512;						/* ָ룬ָµĿ	*/
-	CURRENT->sector++;							/* ʼż1	*/
-	if (--CURRENT->nr_sectors) {				/* ûж꣬	*/
+/* In multiple mode the drive interrupts once per block of cur_mult
+ * sectors (the last one may be shorter), so take them all here. */
+	n = CURRENT->nr_sectors;
+	if (n > cur_mult)
+		n = cur_mult;
+	do {
+		port_read(HD_DATA,CURRENT->buffer,256);		/* ݴݼĴڶṹ	*/
+		CURRENT->errors = 0;						/* 	*/
+		CURRENT->buffer += 512;						/* ָ룬ָµĿ	*/
+		CURRENT->sector++;							/* ʼż1	*/
+		i = --CURRENT->nr_sectors;
+/* A request may span several buffers: each one is finished as soon as its
+ * last sector is in, and end_request() moves on to the next. */
+/* һܰ飺ÿһ͵end_request()ÿ飬
+ * Ŵһ顣	*/
+		if (!--CURRENT->current_nr_sectors)
+			end_request(1);
+	} while (i && --n);
+	if (i) {									/* ûж꣬	*/
 		do_hd = &read_intr;						/* ٴӲ̵C ָΪread_intr()	*/
 		return;									/* ΪӲжϴÿεdo_hd ʱ	*/
 	}											/* Ὣúָÿաμsystem_call.s	*/
-/* ִеˣ˵ȫѾ꣬end_requestOȥ
-ˡٴεdo_hd_requestOȥӲִӲ
+/* ִеˣ˵ȫѾ꣬һend_request()
+˸ٴεdo_hd_requestOȥӲ
 */
-	end_request(1);								/* ȫѾ꣬ˣ	*/
-	do_hd_request();							/* ִӲѸ±־λ1	*/
+	do_hd_request();							/* ִӲ	*/
+}
+
+/*
+ * hd_write_sectors() feeds the next block of at most cur_mult sectors
+ * to the drive. It works from its own copy of the request, 'wreq', as
+ * the data goes out one block ahead of what write_intr() has seen
+ * acknowledged, and steps along the buffer chain on its own.
+ */
+static void hd_write_sectors(int n)
+{
+	if (n > cur_mult)
+		n = cur_mult;
+	while (n--) {
+		port_write(HD_DATA,wreq.buffer,256);
+		wreq.buffer += 512;
+		if (!--wreq.current_nr_sectors && wreq.bh &&
+		    (wreq.bh = wreq.bh->b_reqnext)) {
+			wreq.buffer = wreq.bh->b_data;
+			wreq.current_nr_sectors = BLOCK_SIZE >> 9;
+		}
+	}
 }
 
 /* джϵúӲжϴбá	*/
@@ -438,6 +604,8 @@ static void read_intr(void)
 ͻִиú	*/
 static void write_intr(void)
 {
+	int i, n;
+
 /* úжϴ˴дǷæ״̬
 ִдӲ̲ʧ⣬ٴӲλִ
 Ȼ󷵻ءbad_rw_intrOУÿβԵǰۼƣ
@@ -457,17 +625,26 @@ static void write_intr(void)
 ݶ˿д512ֽݣȻȥȴЩдӲ̺
 жϡ
 */
-	if (--CURRENT->nr_sectors) {				/* д1Ҫд	*/
-		CURRENT->sector++;						/* ǰʼ+1	*/
-		CURRENT->buffer += 512;					/* 󻺳ָ룬	*/
+/* The sectors just written are the cur_mult (or fewer) that
+ * hd_write_sectors() sent: account for them all. */
+	n = CURRENT->nr_sectors;
+	if (n > cur_mult)
+		n = cur_mult;
+	do {
+		i = --CURRENT->nr_sectors;					/* д1	*/
+		CURRENT->sector++;							/* ǰʼ+1	*/
+		CURRENT->buffer += 512;						/* 󻺳ָ룬	*/
+		if (!--CURRENT->current_nr_sectors)			/* ǰд꣬ÿ飬	*/
+			end_request(1);							/* ָָһ顣	*/
+	} while (i && --n);
+	if (i) {									/* Ҫд	*/
 		do_hd = &write_intr;					/* ӲжϳúָΪwrite_intr()	*/
-		port_write(HD_DATA,CURRENT->buffer,256);/* ݼĴ˿д256 ֽڡ	*/
+		hd_write_sectors(i);					/* ݼĴ˿д256 ֽڡ	*/
 		return;									/* صȴӲٴджϴ	*/
 	}
-/* ȫѾд꣬end_requestOȥˡ
-ٴεdo_hd_requestOȥӲִӲ
+/* ȫѾд꣬һend_request()Ѿ˸
+ٴεdo_hd_requestOȥӲ
 */
-	end_request(1);								/* ȫѾд꣬ˣ	*/
 	do_hd_request();							/* ִӲ	*/
 }
 
@@ -487,6 +664,122 @@ static void recal_intr(void)
 	do_hd_request();
 }
 
+/*
+ * The drive and the bus-master engine both signal the end of a DMA
+ * transfer with this one interrupt, so the whole request is done:
+ * finish each of its buffers in turn, counting nr_sectors down so we
+ * stop with the last one (a paging request has just the one). A
+ * bus-master error puts the drive back on PIO for the retry and from
+ * then on.
+ */
+static void dma_intr(void)
+{
+	int i,stat;
+
+	outb(inb(hd_dma_base+BM_COMMAND) & ~BM_START,hd_dma_base+BM_COMMAND);
+	stat = inb(hd_dma_base+BM_STATUS);
+	outb(stat | BM_ERR | BM_INTR,hd_dma_base+BM_STATUS);
+	if (stat & BM_ERR) {
+		printk("hd%c: DMA error, using PIO\n\r",'a'+CURRENT_DEV);
+		dma_drives &= ~(1<<CURRENT_DEV);
+	}
+	if (win_result() || (stat & BM_ERR)) {
+		bad_rw_intr();
+		do_hd_request();
+		return;
+	}
+	do {
+		CURRENT->nr_sectors -= CURRENT->current_nr_sectors;
+		i = CURRENT->nr_sectors;
+		end_request(1);
+	} while (i);
+	do_hd_request();
+}
+
+/*
+ * Fill prd_table from CURRENT's buffer chain, running physically
+ * adjacent buffers together where that doesn't cross 64kB.
+ */
+static void hd_build_prd(void)
+{
+	struct hd_prd * p = prd_table;
+	struct buffer_head * bh = CURRENT->bh;
+	unsigned long addr;
+
+	p->addr = (unsigned long) CURRENT->buffer;
+	p->count = CURRENT->current_nr_sectors << 9;
+	while (bh && (bh = bh->b_reqnext)) {
+		addr = (unsigned long) bh->b_data;
+		if (addr == p->addr + p->count &&
+		    !((addr ^ (addr + BLOCK_SIZE - 1)) & ~0xffff) &&
+		    !((addr ^ p->addr) & ~0xffff))
+			p->count += BLOCK_SIZE;
+		else {
+			if (++p == prd_table + NR_PRD)
+				panic("hd: request overruns PRD table");
+			p->addr = addr;
+			p->count = BLOCK_SIZE;
+		}
+	}
+	p->count |= PRD_EOT;
+}
+
+static void hd_dma_start(unsigned int drive,unsigned int nsect,
+	unsigned int sec,unsigned int head,unsigned int cyl)
+{
+	int rd = (CURRENT->cmd == READ);
+
+	hd_build_prd();
+	outl((unsigned long) prd_table,hd_dma_base+BM_PRD);
+	outb(rd ? BM_READ : 0,hd_dma_base+BM_COMMAND);
+	outb(inb(hd_dma_base+BM_STATUS) | BM_ERR | BM_INTR,
+		hd_dma_base+BM_STATUS);
+	hd_out(drive,nsect,sec,head,cyl,rd ? WIN_READDMA : WIN_WRITEDMA,
+		&dma_intr);
+	outb(inb(hd_dma_base+BM_COMMAND) | BM_START,hd_dma_base+BM_COMMAND);
+}
+
+/*
+ * If the drive refuses SET MULTIPLE we simply drop back to one
+ * sector per interrupt for it.
+ */
+static void setmult_intr(void)
+{
+	if (win_result()) {
+		printk("hd%c: SET MULTIPLE failed, using single sectors\n\r",
+			'a'+CURRENT_DEV);
+		hd_info[CURRENT_DEV].mult = 0;
+	}
+	do_hd_request();
+}
+
+/*
+ * Blocks merged onto a request are only checked against the partition
+ * here. Those past its end are all at the tail of the chain: fail just
+ * them, and keep the first 'left' sectors, which are in range.
+ */
+/* ϲó˷ĩˣֵĻ鶼ĩβֻʧܣ
+ * ǰleft ڷڣ	*/
+static void trim_request(unsigned long left)
+{
+	struct buffer_head *bh, *next;
+
+	CURRENT->nr_sectors = CURRENT->current_nr_sectors;
+	for (bh = CURRENT->bh; bh->b_reqnext &&
+	     CURRENT->nr_sectors + (BLOCK_SIZE >> 9) <= left; bh = bh->b_reqnext)
+		CURRENT->nr_sectors += BLOCK_SIZE >> 9;
+	next = bh->b_reqnext;
+	bh->b_reqnext = NULL;
+	CURRENT->bhtail = bh;
+	while ((bh = next)) {
+		printk("hd: block %d beyond end of partition\n\r", bh->b_blocknr);
+		next = bh->b_reqnext;
+		bh->b_reqnext = NULL;
+		bh->b_uptodate = 0;
+		unlock_buffer(bh);
+	}
+}
+
 /* ִӲ̶д
 ú豸ǰе豸źʼϢȼõӦӲϵš
 ǰŵšͷݣȻٸеREAD/WRITEӲ̷Ӧ
@@ -515,13 +808,15 @@ void do_hd_request(void)
 	INIT_REQUEST;
 	dev = MINOR(CURRENT->dev);
 	block = CURRENT->sector;			/* ʼ	*/
-/* 豸Ųڻʼڸ÷-2󣬲תrepeat 	*/
-/* INIT_REQUEST ʼΪһҪд2 512*2 ֽڣ	*/
-/* ܴڷڶš	*/
-	if (dev >= 5*NR_HD || block+2 > hd[dev].nr_sects) {
+/* 豸Ųڻߵǰ鳬ûʧܣתrepeat 	*/
+/* INIT_REQUEST ʼеһ顣ֻǺϲĿ鳬	*/
+/* ֻЩʧܡ	*/
+	if (dev >= 5*NR_HD || block+CURRENT->current_nr_sectors > hd[dev].nr_sects) {
 		end_request(0);
 		goto repeat;					/* ñblk.h 档	*/
 	}
+	if (block+CURRENT->nr_sectors > hd[dev].nr_sects)
+		trim_request(hd[dev].nr_sects - block);
 	block += hd[dev].start_sect;		/* ĿӦӲϵľš	*/
 	dev /= 5;							/* ʱdev Ӳ̺ţӲ0 Ӳ1	*/
 /* ȻõľblockӲ̺devǾͿԼӦӲеĴŵ
@@ -534,11 +829,20 @@ void do_hd_request(void)
 ĶӦܴŵӲܴͷhdinf0[dev].headeaxеõֵ
 ţcyl, edxеõǶӦõǰͷţhead
 */
-	__asm__("divl %4":"=a" (block),"=d" (sec):"0" (block),"1" (0),
-		"r" (hd_info[dev].sect));
-	__asm__("divl %4":"=a" (cyl),"=d" (head):"0" (block),"1" (0),
-		"r" (hd_info[dev].head));
-	sec++;								/* ԼõǰŵŽе	*/
+/* An LBA28 drive takes the sector number as it is: bits 0-7 go in the
+ * sector register, 8-23 in the cylinder ones and 24-27 in the head
+ * nibble, with HD_LBA set. Only CHS drives need the divisions. */
+	if (lba_drives & (1<<dev)) {
+		sec = block & 0xff;
+		cyl = (block >> 8) & 0xffff;
+		head = HD_LBA | ((block >> 24) & 0x0f);
+	} else {
+		__asm__("divl %4":"=a" (block),"=d" (sec):"0" (block),"1" (0),
+			"r" (hd_info[dev].sect));
+		__asm__("divl %4":"=a" (cyl),"=d" (head):"0" (block),"1" (0),
+			"r" (hd_info[dev].head));
+		sec++;								/* ԼõǰŵŽе	*/
+	}
 	nsect = CURRENT->nr_sectors;		/* /д	*/
 /* ʱǵõдӲʼblockӦӲ(cyl)ڵǰŵ
 ϵţsecͷţheadԼдnsectǿԸ
@@ -553,6 +857,7 @@ void do_hd_request(void)
 	if (reset) {
 		reset = 0;
 		recalibrate = 1;				/* У־	*/
+		setmult = (1<<MAX_HD)-1;		/* a reset drops multiple mode */
 		reset_hd(CURRENT_DEV);
 		return;
 	}
@@ -568,10 +873,26 @@ void do_hd_request(void)
 			WIN_RESTORE,&recal_intr);
 		return;
 	}
+	if (setmult & (1<<dev)) {
+		setmult &= ~(1<<dev);
+		if (hd_info[dev].mult) {
+			hd_out(dev,hd_info[dev].mult,0,0,0,
+				WIN_SETMULT,&setmult_intr);
+			return;
+		}
+	}
+	cur_mult = hd_info[dev].mult ? hd_info[dev].mult : 1;
+	if (dma_drives & (1<<dev)) {
+		if (CURRENT->cmd != READ && CURRENT->cmd != WRITE)
+			panic("unknown hd-command");
+		hd_dma_start(dev,nsect,sec,head,cyl);
+		return;
+	}
 /* ǰддѭȡ״̬ĴϢж־	*/
 /* DRQ_STAT ǷλDRQ_STAT Ӳ״̬Ĵλinclude/linux/hdreg.h27	*/
 	if (CURRENT->cmd == WRITE) {
-		hd_out(dev,nsect,sec,head,cyl,WIN_WRITE,&write_intr);
+		hd_out(dev,nsect,sec,head,cyl,
+			hd_info[dev].mult ? WIN_MULTWRITE : WIN_WRITE,&write_intr);
 		for(i=0 ; i<3000 && !(r=inb_p(HD_STATUS)&DRQ_STAT) ; i++)
 			/* nothing */ ;
 /* nothing */ ;
@@ -582,10 +903,12 @@ void do_hd_request(void)
 			bad_rw_intr();
 			goto repeat;
 		}
-		port_write(HD_DATA,CURRENT->buffer,256);
+		wreq = *CURRENT;
+		hd_write_sectors(nsect);
 /* ǰǶӲݣӲ̿ͶЧͣ	*/
 	} else if (CURRENT->cmd == READ) {
-		hd_out(dev,nsect,sec,head,cyl,WIN_READ,&read_intr);
+		hd_out(dev,nsect,sec,head,cyl,
+			hd_info[dev].mult ? WIN_MULTREAD : WIN_READ,&read_intr);
 	} else
 		panic("unknown hd-command");
 }
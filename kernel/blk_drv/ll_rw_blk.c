@@ -15,6 +15,7 @@
 							/* һЩйúͻȡǶʽຯ䡣	*/
 #include <linux/kernel.h>	/* ںͷļһЩں˳úԭζ塣	*/
 #include <asm/system.h>		/* ϵͳͷļû޸/жŵȵǶʽꡣ	*/
+#include <asm/segment.h>	/* βͷļйضμĴǶʽຯ	*/
 #include "blk.h"			/* 豸ͷļݽṹ豸ݽṹͺ꺯Ϣ	*/
 
 /*
@@ -30,7 +31,7 @@ struct request request[NR_REQUEST];
 * used to wait on when there are no free requests
 */
 /* ûпʱʱȴ */
-struct task_struct *wait_for_request = NULL;
+struct wait_queue_head wait_for_request;
 
 /* blk_dev_struct is:
 * do_request-address
@@ -51,6 +52,20 @@ struct blk_dev_struct blk_dev[NR_BLK_DEV] = {
 	{NULL, NULL}			/* dev lp	6 - lp ӡ豸	*/
 };
 
+/*
+ * read_ahead[] is the maximum readahead window, in blocks, that file_read()
+ * may use on files of each major. The ramdisk doesn't need any. It can be
+ * changed with the BLKRASET ioctl.
+ */
+/* 豸Ԥڣioctl(BLKRASET)޸ġ	*/
+int read_ahead[NR_BLK_DEV] = {
+	0,						/* no_dev */
+	0,						/* dev mem (ramdisk) */
+	8,						/* dev fd */
+	16,						/* dev hd */
+	0, 0, 0
+};
+
 /* ָĻbh
 * ָĻѾʹԼ˯ߣжϵصȴ
 * ֱִнȷػѡ	*/
@@ -128,6 +143,48 @@ static void add_request (struct blk_dev_struct *dev, struct request *req)
 }
 
 /* Сmajor豸ţrwָbhǴݵĻͷָ롣	*/
+/*
+ * merge_request() tries to put bh into an already queued request for the
+ * same device and direction, right after or before it on the disk. It
+ * returns 1 if it did, 0 if a new request is needed.
+ */
+/* ԽϲСɹ1򷵻0	*/
+static int
+merge_request (struct blk_dev_struct *dev, int rw, struct buffer_head *bh)
+{
+	struct request *req;
+	unsigned long sector = bh->b_blocknr << 1;
+
+	cli ();
+	if (!(req = dev->current_request)) {
+		sti ();
+		return 0;
+	}
+	for (req = req->next; req; req = req->next) {
+		if (req->dev != bh->b_dev || req->cmd != rw || !req->bh ||
+		    req->nr_sectors + 2 > MAX_SECTORS)
+			continue;
+		if (req->sector + req->nr_sectors == sector) {
+			bh->b_reqnext = NULL;
+			req->bhtail->b_reqnext = bh;
+			req->bhtail = bh;
+		} else if (req->sector == sector + 2) {
+			bh->b_reqnext = req->bh;
+			req->bh = bh;
+			req->buffer = bh->b_data;
+			req->current_nr_sectors = 2;
+			req->sector = sector;
+		} else
+			continue;
+		req->nr_sectors += 2;
+		bh->b_dirt = 0;
+		sti ();
+		return 1;
+	}
+	sti ();
+	return 0;
+}
+
 static void
 make_request (int major, int rw, struct buffer_head *bh)
 {
@@ -175,6 +232,14 @@ make_request (int major, int rw, struct buffer_head *bh)
 			unlock_buffer (bh);
 			return;
 		}
+/* Try to add the buffer to a queued request for an adjacent block: at the
+ * end (back merge) or the front (front merge) of it. The first request is
+ * being worked on by the driver, so it's left alone. Only the harddisk
+ * driver handles buffer chains. */
+/* Űѻϲеġڵͬĩβͷеһ
+ * ڱܺϲĿǰֻӲܴ	*/
+	if (major == 3 && merge_request (major + blk_dev, rw, bh))
+		return;
 repeat:
 /* we don't allow the write-requests to fill up the queue completely:
 * we want some room for reads: they take precedence. The last third
@@ -226,9 +291,12 @@ req-)sector
 	req->errors = 0;						/* ʱĴ	*/
 	req->sector = bh->b_blocknr << 1;		/* ʼ(1 =2 )	*/
 	req->nr_sectors = 2;					/* д	*/
+	req->current_nr_sectors = 2;
 	req->buffer = bh->b_data;				/* ݻ	*/
 	req->waiting = NULL;					/* ȴִɵĵط	*/
 	req->bh = bh;							/* ͷָ롣	*/
+	req->bhtail = bh;
+	bh->b_reqnext = NULL;
 	req->next = NULL;						/* ָһ	*/
 	add_request (major + blk_dev, req);		/* (blk_dev[major],req)	*/
 }
@@ -258,6 +326,51 @@ ll_rw_block (int rw, struct buffer_head *bh)
 	make_request (major, rw, bh);			/* С	*/
 }
 
+/*
+ * ll_rw_page() reads or writes one page of memory at page number 'page'
+ * of dev, and waits for it. It is what swapping uses: the request has
+ * no buffer behind it, so it is never merged with others.
+ */
+void
+ll_rw_page (int rw, int dev, int page, char *buffer)
+{
+	struct request *req;
+	unsigned int major = MAJOR (dev);
+
+	if (major >= NR_BLK_DEV || !(blk_dev[major].request_fn))
+		{
+			printk ("Trying to read nonexistent block-device\n\r");
+			return;
+		}
+	if (rw != READ && rw != WRITE)
+		panic ("Bad block dev command, must be R/W");
+repeat:
+	req = request + NR_REQUEST;
+	while (--req >= request)
+		if (req->dev < 0)
+			break;
+	if (req < request)
+		{
+			sleep_on (&wait_for_request);
+			goto repeat;
+		}
+/* fill up the request-info, and add it to the queue */
+	req->dev = dev;
+	req->cmd = rw;
+	req->errors = 0;
+	req->sector = page << 3;
+	req->nr_sectors = 8;
+	req->current_nr_sectors = 8;
+	req->buffer = buffer;
+	req->waiting = current;
+	req->bh = NULL;
+	req->bhtail = NULL;
+	req->next = NULL;
+	current->state = TASK_UNINTERRUPTIBLE;
+	add_request (major + blk_dev, req);
+	schedule ();
+}
+
 /* 豸ʼɳʼmain.c ãinit/main.c,128	*/
 /* ʼ飬Ϊ(dev = -1)32 (NR_REQUEST = 32)	*/
 void
@@ -271,3 +384,32 @@ blk_dev_init (void)
 			request[i].next = NULL;
 		}
 }
+
+/*
+ * ioctl()s common to all block devices. Only the readahead window can be
+ * read and set for now.
+ */
+/* 豸ioctl 	*/
+int
+blk_ioctl (int dev, int cmd, int arg)
+{
+	int major = MAJOR (dev);
+
+	if (major >= NR_BLK_DEV || !blk_dev[major].request_fn)
+		return -ENODEV;
+	switch (cmd) {
+		case BLKRAGET:
+			verify_area ((void *) arg, 4);
+			put_fs_long (read_ahead[major], (unsigned long *) arg);
+			return 0;
+		case BLKRASET:
+			if (!suser ())
+				return -EPERM;
+			if (arg < 0 || arg > MAX_READAHEAD)
+				return -EINVAL;
+			read_ahead[major] = arg;
+			return 0;
+		default:
+			return -EINVAL;
+	}
+}
@@ -30,8 +30,8 @@ size = 1024
 rs_addr 	= 0			/* ж˿ںֶƫƣ˿ں0x3f8 0x2f8	*/
 head		= 4			/* ͷֶָƫơ	*/
 tail		= 8			/* βֶָƫơ	*/
-proc_list	= 12		/* ȴûĽֶƫơ	*/
-buf			= 16		/* ֶƫơ	*/
+proc_list	= 12		/* ȴûĽ̶ֶƫ(struct wait_queue_head8 ֽ)	*/
+buf			= 20		/* ֶƫơ	*/
 
 /* һдں˾ͻҪдַĽΪȴ״̬д	*/
 /*лʣ256ַʱжϴͿԻЩȴ̼дзַ	*/
@@ -175,11 +175,10 @@ write_char:
 	je		write_buffer_empty	/* ͷָ = βָ룬˵дַת	*/
 	cmpl	$startup,%ebx		/* ַ256 	*/
 	ja		1f					/* ת	*/
-	movl	proc_list(%ecx),%ebx /* wake up sleeping process	ѵȴĽ̡	*/
-								/* ȡȴöеĽ̵ָ룬жǷΪա	*/
-	testl	%ebx,%ebx			/* is there any?	еȴĽ	*/
-	je		1f					/* ǿյģǰת1 	*/
-	movl	$0,(%ebx)			/* 򽫽Ϊ״̬(ѽ)	*/
+	cmpl	$0,proc_list(%ecx)	/* wake up sleeping process	ѵȴĽ̡	*/
+								/* ȴͷfirst ָΪձʾûеȴĽ̡	*/
+	je		1f					/* is there any?	ǿյģǰת1 	*/
+	call	wake_queue			/* ѵȴϵĽ̡	*/
 1: movl		tail(%ecx),%ebx		/* ȡβָ롣	*/
 	movb	buf(%ecx,%ebx),%al	/* ӻβָ봦ȡһַ>al	*/
 	outb	%al,%dx				/* ˿0x3f8(0x2f8)ͳּĴС	*/
@@ -190,6 +189,20 @@ write_char:
 	je		write_buffer_empty	/* ȣʾѿգת	*/
 	ret
 
+/* ecx ָеĵȴ˯ߵн̡C wake_up()ǰ
+* ޸ĵecxedx Ĵ(eax ڵôʹ)	*/
+.align	2
+wake_queue:
+	pushl	%edx
+	pushl	%ecx
+	leal	proc_list(%ecx),%eax	/* ȴͷַΪ	*/
+	pushl	%eax
+	call	_wake_up
+	addl	$4,%esp
+	popl	%ecx
+	popl	%edx
+	ret
+
 /* дwriteqѿյеȴдôն˵Ľ֮Ȼη
 * ͱּĴжϣ÷ͱּĴʱжϡ
 * ʱдwrite_qѿգʾǰַҪ͡Ӧ顣
@@ -200,11 +213,9 @@ write_char:
 */
 .align	2
 write_buffer_empty:
-	movl	proc_list(%ecx),%ebx /* wake up sleeping process	ѵȴĽ̡	*/
-								/* ȡȴöеĽ̵ָ룬жǷΪա	*/
-	testl	%ebx,%ebx			/* is there any?	еȴĽ	*/
-	je		1f					/* ޣǰת1 	*/
-	movl	$0,(%ebx)			/* 򽫽Ϊ״̬(ѽ)	*/
+	cmpl	$0,proc_list(%ecx)	/* wake up sleeping process	ѵȴĽ̡	*/
+	je		1f					/* is there any?	ޣǰת1 	*/
+	call	wake_queue			/* ѵȴϵĽ̡	*/
 1: incl		%edx				/* ָ˿0x3f9(0x2f9)	*/
 	inb		%dx,%al				/* ȡжĴ	*/
 	jmp		1f					/* ӳ١	*/
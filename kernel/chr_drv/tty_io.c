@@ -73,9 +73,9 @@ struct tty_struct tty_table[] = {
 	0,				/* initial pgrp	*/				/* ʼ顣	*/
 	0,				/* initial stopped	*/			/* ʼֹͣ־	*/
 	con_write,										/* tty дָ롣	*/
-	{0, 0, 0, 0, ""},/* console read-queue */		/* tty ̨С	*/
-	{0, 0, 0, 0, ""},/* console write-queue */		/* tty ̨дС	*/
-	{0, 0, 0, 0, ""}/* console secondary queue */	/* tty ̨(2)С	*/
+	{0, 0, 0, {0, 0}, ""},/* console read-queue */		/* tty ̨С	*/
+	{0, 0, 0, {0, 0}, ""},/* console write-queue */		/* tty ̨дС	*/
+	{0, 0, 0, {0, 0}, ""}/* console secondary queue */	/* tty ̨(2)С	*/
   },{
 		{ 0, 		/* no translation	*/			/* ģʽ־ 0ת	*/
 		  0,		/* no translation	*/			/* ģʽ־ 0ת	*/
@@ -86,9 +86,9 @@ struct tty_struct tty_table[] = {
 		0,										/* ʼ顣	*/
 		0,										/* ʼֹͣ־	*/
 		rs_write,								/* 1 tty дָ롣	*/
-		{0x3f8, 0, 0, 0, ""},	/* rs 1 */		/* ն1 нṹʼֵ	*/
-		{0x3f8, 0, 0, 0, ""},					/* ն1 днṹʼֵ	*/
-		{0, 0, 0, 0, ""}						/* ն1 нṹʼֵ	*/
+		{0x3f8, 0, 0, {0, 0}, ""},	/* rs 1 */		/* ն1 нṹʼֵ	*/
+		{0x3f8, 0, 0, {0, 0}, ""},					/* ն1 днṹʼֵ	*/
+		{0, 0, 0, {0, 0}, ""}						/* ն1 нṹʼֵ	*/
   },{
 		{ 0,		/* no translation	*/		/* ģʽ־ 0ת	*/
 		  0,		/* no translation	*/		/* ģʽ־ 0ת	*/
@@ -99,9 +99,9 @@ struct tty_struct tty_table[] = {
 		0,										/* ʼ顣	*/
 		0,										/* ʼֹͣ־	*/
 		rs_write,								/* 2 tty дָ롣	*/
-		{0x2f8, 0, 0, 0, ""},					/*  rs 2 */ /*ն2нṹʼֵ	*/
-		{0x2f8, 0, 0, 0, ""},					/* ն2днṹʼֵ	*/
-		{0, 0, 0, 0, ""}						/* ն2нṹʼֵ	*/
+		{0x2f8, 0, 0, {0, 0}, ""},					/*  rs 2 */ /*ն2нṹʼֵ	*/
+		{0x2f8, 0, 0, {0, 0}, ""},					/* ն2днṹʼֵ	*/
+		{0, 0, 0, {0, 0}, ""}						/* ն2нṹʼֵ	*/
 		}
 };
 
@@ -145,7 +145,10 @@ void tty_intr (struct tty_struct *tty, int mask)
  * ָ벻Ϊգŵttyţãָͣźmask	*/
 	for (i = 0; i < NR_TASKS; i++)
 		if (task[i] && task[i]->pgrp == tty->pgrp)
+		{
 			task[i]->signal |= mask;
+			signal_wake_up (task[i]);
+		}
 }
 
 /* лý̽ж˯״̬
@@ -383,7 +386,7 @@ int tty_read (unsigned channel, char *buf, int nr)
 /* ԭʱֵ0 time+ǰϵͳʱֵСڽԭʱֵĻý̶ʱ	*/
 /* ֵΪtime+ǰϵͳʱ䣬flag ־	*/
 		if (flag = (!oldalarm || time + jiffies < oldalarm))
-			current->alarm = time + jiffies;
+			set_alarm (current, time + jiffies);
 	}
 /* õٶȡַ>ַڴ˴ȡַ	*/
 	if (minimum > nr)
@@ -458,9 +461,9 @@ int tty_read (unsigned channel, char *buf, int nr)
  * ԭʱʱ͵ˡˣʱҪ̵ָԭʱֵoldalarm	*/
 			if (time && !L_CANON (tty))
 		if (flag = (!oldalarm || time + jiffies < oldalarm))
-			current->alarm = time + jiffies;
+			set_alarm (current, time + jiffies);
 		else
-			current->alarm = oldalarm;
+			set_alarm (current, oldalarm);
 /* ⣬˹淶ģʽ־ôѶһַжѭѶȡ
  * ڻҪȡַҲжѭ	*/
 				if (L_CANON (tty))
@@ -473,7 +476,7 @@ int tty_read (unsigned channel, char *buf, int nr)
 	}
 /* ʱȡttyַѭý̵Ķʱֵָԭֵ̽յ
  * Ųûжȡκַ򷵻سţжϣ򷵻Ѷַ	*/
-	current->alarm = oldalarm;
+	set_alarm (current, oldalarm);
 	if (current->signal && !(b - buf))
 		return -EINTR;
 	return (b - buf);		/* Ѷȡַ	*/
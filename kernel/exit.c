@@ -16,26 +16,23 @@ int sys_pause (void);
 int sys_close (int fd);
 
 /* ͷָռõۼݽṹռõڴҳ档
-Pݽṹָ롣úںsyskillOSySWaitpid()бá
-ɨָtask[]ѰָҵոۣȻͷ
-ݽṹռõڴҳ棬ִеȺڷʱ˳
-ûҵָӦںpanic
+Pݽṹָ롣úںsyswaitpid()бá
+ṹм¼Լţֱո۲黹ţٰӽ̺ɢ
+͸̵ӽȡ£ȻͷŸݽṹռõڴҳ棬ִе
+鲻ںpanic
 */
 void release (struct task_struct *p)
 {
-	int i;
-
 	if (!p)							/* ݽṹָNULLʲôҲ˳	*/
 		return;
-	for (i = 1; i < NR_TASKS; i++)	/* ɨ飬Ѱָ	*/
-	if (task[i] == p)
-	{
-		task[i] = NULL;				/* ÿոͷڴҳ	*/
-		free_page ((long) p);
-		schedule ();				/* µȡ	*/
-		return;
-	}
-	panic ("trying to release non-existent task");	/* ָ	*/
+	if (p->nr <= 0 || p->nr >= NR_TASKS || task[p->nr] != p)
+		panic ("trying to release non-existent task");	/* ָ	*/
+	task[p->nr] = NULL;				/* ÿո黹š	*/
+	put_task_nr (p->nr);
+	unhash_pid (p);
+	REMOVE_LINKS (p);
+	free_page ((long) p);			/* ͷڴҳ	*/
+	schedule ();					/* µȡ	*/
 }
 
 /* ָPźsig,ȨΪpriv
@@ -54,7 +51,10 @@ send_sig (long sig, struct task_struct *p, int priv)
 suser()Ϊ(current-)euid==0}жǷǳû
 */
 	if (priv || (current->euid == p->euid) || suser ())
+	{
 		p->signal |= (1 << (sig - 1));
+		signal_wake_up (p);
+	}
 	else
 		return -EPERM;
 	return 0;
@@ -71,7 +71,10 @@ kill_session (void)
 	while (--p > &FIRST_TASK)
 	{
 		if (*p && (*p)->session == current->session)
+		{
 			(*p)->signal |= 1 << (SIGHUP - 1);	/* ͹ҶϽźš	*/
+			signal_wake_up (*p);
+		}
 	}
 }
 
@@ -96,6 +99,7 @@ int
 sys_kill (int pid, int sig)
 {
 	struct task_struct **p = NR_TASKS + task;
+	struct task_struct *q;
 	int err, retval = 0;
 
 	if (!pid)
@@ -104,13 +108,11 @@ sys_kill (int pid, int sig)
 			if (*p && (*p)->pgrp == current->pid)
 				if (err = send_sig (sig, *p, 1))	/* ǿƷźš	*/
 					retval = err;
-		}else if (pid > 0) 
-			while (--p > &FIRST_TASK)
-			{
-				if (*p && (*p)->pid == pid)
-					if (err = send_sig (sig, *p, 0))
-						retval = err;
-			}else if (pid == -1)
+		}else if (pid > 0)
+		{
+			if ((q = find_task_by_pid (pid)))
+				retval = send_sig (sig, q, 0);
+		}else if (pid == -1)
 				while (--p > &FIRST_TASK)
 					if (err = send_sig (sig, *p, 0))
 						retval = err;
@@ -122,31 +124,15 @@ sys_kill (int pid, int sig)
 	return retval;
 }
 
-/* ֪ͨһpidźSIGCHLD:Ĭӽֹֹ̽ͣ
-ûҵ̣Լͷšrosix.iҪֹӽӦ
-ʼ1ݡ
+/* ֪ͨһ򸸽̷źSIGCHLD:Ĭӽֹֹ̽ͣ
+posixҪֹӽѾdo_exit()ʼ1ݣ
+p_pptrָһڵĸ̡
 */
 static void
-tell_father (int pid)
+tell_father (struct task_struct *father)
 {
-	int i;
-
-	if (pid)
-/* ɨѰָpid䷢ӽֹֹ̽ͣźSIGCHLD	*/
-		for (i = 0; i < NR_TASKS; i++)
-			{
-	if (!task[i])
-		continue;
-	if (task[i]->pid != pid)
-		continue;
-	task[i]->signal |= (1 << (SIGCHLD - 1));
-	return;
-			}
-/* if we don't find any fathers, we just release ourselves */
-/* This is not really OK. Must change it to make father 1 */
-/* ûҵ̣̾Լͷšãĳɽ1䵱丸̡	*/
-	printk ("BAD BAD - no father found\n\r");
-	release (current);	/* ûҵ̣Լͷš	*/
+	father->signal |= (1 << (SIGCHLD - 1));
+	signal_wake_up (father);
 }
 
 /* ˳137дϵͳôsys_exit()бá
@@ -156,6 +142,8 @@ tell_father (int pid)
 int
 do_exit (long code)		/* code Ǵ롣	*/
 {
+	struct task_struct *p;
+	unsigned long dir;
 	int i;
 
 /* ͷŵǰ̴κݶռڴҳfreepagetablesOĵ1
@@ -166,18 +154,25 @@ do_exit (long code)		/* code 
 ȡγʱʹøöεѡΪfreepagetables()λmm/memory.c
 ļ 105 Уgetbase() getlimit()λ include/linux/sched.h ͷļ 213 д
 */
-	free_page_tables (get_base (current->ldt[1]), get_limit (0x0f));
-	free_page_tables (get_base (current->ldt[2]), get_limit (0x17));
-/* ǰӽ̣ͽӽ̵father Ϊ1(丸̸Ϊ1)ӽѾ	*/
-/* ڽ(ZOMBIE)״̬1 ӽֹźSIGCHLD	*/
-	for (i = 0; i < NR_TASKS; i++)
-		if (task[i] && task[i]->father == current->pid)
-			{
-	task[i]->father = 1;
-	if (task[i]->state == TASK_ZOMBIE)
+	if (current->vfork_dir)
+		release_vfork (current);
+	else
+	{
+		free_page_tables (get_base (current->ldt[1]), get_limit (0x0f));
+		free_page_tables (get_base (current->ldt[2]), get_limit (0x17));
+	}
+/* ǰӽ̣ͰƵ1 ӽ(丸̸Ϊ1)	*/
+/* ӽѾڽ(ZOMBIE)״̬1 ӽֹźSIGCHLD	*/
+	while ((p = current->p_cptr))
+	{
+		REMOVE_LINKS (p);
 /* assumption task[1] is always init */	/*  task[l]϶ǽ init 	*/
-		(void) send_sig (SIGCHLD, task[1], 1);
-			}
+		p->p_pptr = task[1];
+		p->father = 1;
+		SET_LINKS (p);
+		if (p->state == TASK_ZOMBIE)
+			(void) send_sig (SIGCHLD, task[1], 1);
+	}
 /* رյǰ̴ŵļ	*/
 	for (i = 0; i < NR_OPEN; i++)
 		if (current->filp[i])
@@ -189,6 +184,9 @@ do_exit (long code)		/* code 
 	current->pwd = NULL;
 	iput (current->root);
 	current->root = NULL;
+	if (current->executable)
+		unlink_executable (current);
+	exit_mmap (current);
 	iput (current->executable);
 	current->executable = NULL;
 /* ǰͷ(leader)̲пƵնˣͷŸնˡ	*/
@@ -200,11 +198,17 @@ do_exit (long code)		/* code 
 /* ǰleader ֹ̣ؽ̡	*/
 	if (current->leader)
 		kill_session ();
+	set_alarm (current, 0);
+/* ں˵ҳĿ¼pg_dirͷԼҳĿ¼ʱҳѾͷţҲٻصû̬	*/
+	dir = current->tss.cr3;
+	current->tss.cr3 = (unsigned long) pg_dir;
+	load_cr3 (pg_dir);
+	free_page_dir (dir);
 /* ѵǰΪ״̬ǰѾͷԴ潫ɸ̶ȡ˳롣	*/
 	current->state = TASK_ZOMBIE;
 	current->exit_code = code;
 /* ֪̣ͨҲ򸸽̷źSIGCHLD -- ӽֹֹ̽ͣ	*/
-	tell_father (current->father);
+	tell_father (current->p_pptr);
 	schedule ();	/* µȽУø̴ƺˡ
 returnȥϢΪأںǰӹؼ
 volatile,ͿԸgcc᷵صgccһ
@@ -242,25 +246,21 @@ int
 sys_waitpid (pid_t pid, unsigned long *stat_addr, int options)
 {
 	int flag, code;		/* flag־ںʾѡӽ̴ھ˯̬	*/
-	struct task_struct **p;
+	struct task_struct *p;
 
 	verify_area (stat_addr, 4);
 repeat:
 	flag = 0;
-	/* ĩ˿ʼɨԼǵǰ̵ӽ	*/
-	for (p = &LAST_TASK; p > &FIRST_TASK; --p)
-	{									/* ĩ˿ʼɨ	*/
-		if (!*p || *p == current)			/* ͱ	*/
-			continue;
-		if ((*p)->father != current->pid)	/* ǵǰ̵ӽ	*/
-			continue;
+	/* ӽ̿ʼɨ赱ǰ̵ӽ̡	*/
+	for (p = current->p_cptr; p; p = p->p_osptr)
+	{
 /* ʱɨѡ񵽵ĽP϶ǵǰ̵ӽ̡
 ȴӽ̺pid>0뱻ɨӽPpidȣ˵ǵǰ
 ̣ỵ́ɨһ̡
 */
 		if (pid > 0)
 		{									/* ָpid>0ɨĽpid	*/
-			if ((*p)->pid != pid)				/* ֮ȣ	*/
+			if (p->pid != pid)				/* ֮ȣ	*/
 				continue;
 /* ָȴ̵pid=0ʾڵȴŵڵǰŵκӽ̡
 ʱɨPĽ뵱ǰ̵Ųȣ
@@ -268,7 +268,7 @@ repeat:
 		}
 		else if (!pid)
 		{									/* ָpid=0ɨĽ	*/
-			if ((*p)->pgrp != current->pgrp)	/* 뵱ǰ̵Ųȣ	*/
+			if (p->pgrp != current->pgrp)	/* 뵱ǰ̵Ųȣ	*/
 				continue;
 /* ָPid<-1ʾڵȴŵpidֵκӽ̡ʱ
 ɨPpidľֵȣ
@@ -276,7 +276,7 @@ repeat:
 		}
 		else if (pid != -1)
 		{									/* ָpid<-1ɨĽ	*/
-			if ((*p)->pgrp != -pid)			/* ֵȣ	*/
+			if (p->pgrp != -pid)			/* ֵȣ	*/
 				continue;
 		}
 /* ǰ3pidж϶ϣʾǰڵȴκӽ̣Ҳpid =-1
@@ -284,7 +284,7 @@ repeat:
 ӽ̣ǽ̺ŵָpidֵӽ̣κӽ̣ʱָpid
 -1ӽp״̬
 */
-		switch ((*p)->state)
+		switch (p->state)
 		{
 /* ӽPڽ״̬Ȱû̬ں̬еʱֱۼƵǰ
 ()УȻȡӽ̵pid˳룬ͷŸӽ̡󷵻ӽ̵˳pid
@@ -293,13 +293,13 @@ repeat:
 				if (!(options & WUNTRACED))
 					continue;
 				put_fs_long (0x7f, stat_addr);	/* ״̬ϢΪ0x7f	*/
-				return (*p)->pid;					/* ˳ӽ̵Ľ̺š	*/
+				return p->pid;					/* ˳ӽ̵Ľ̺š	*/
 			case TASK_ZOMBIE:
-				current->cutime += (*p)->utime;	/* µǰ̵ӽû	*/
-				current->cstime += (*p)->stime;	/* ̬ͺ̬ʱ䡣	*/
-				flag = (*p)->pid;				/* ʱӽpid	*/
-				code = (*p)->exit_code;			/* ȡӽ̵˳롣	*/
-				release (*p);					/* ͷŸӽ̡	*/
+				current->cutime += p->utime;	/* µǰ̵ӽû	*/
+				current->cstime += p->stime;	/* ̬ͺ̬ʱ䡣	*/
+				flag = p->pid;				/* ʱӽpid	*/
+				code = p->exit_code;			/* ȡӽ̵˳롣	*/
+				release (p);					/* ͷŸӽ̡	*/
 				put_fs_long (code, stat_addr);	/* ״̬ϢΪ˳ֵ	*/
 				return flag;					/* ˳ӽ̵pid.	*/
 /* ӽp״̬ȲֹͣҲǽôflag=lʾҵһ
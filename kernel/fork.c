@@ -28,6 +28,73 @@ extern void write_verify(unsigned long address);
 
 long last_pid=0;	/* ½̺ţֵ get_empty_process()ɡ	*/
 
+/*
+ * Task numbers come off a free list, so fork() doesn't search the task
+ * table for one. Numbers never used yet are taken from a high-water
+ * mark; freed ones are chained through next_task[]. Task 0 is never
+ * freed, so 0 ends the chain.
+ */
+/* Ŵӿȡãfork()Ϊ顣δùĺŴӸˮλ
+ * ȡãͷŵĺͨnext_task[]ӡ0 Ӳͷţ0 ʾ	*/
+static short next_task[NR_TASKS];
+static int free_task = 0, task_mark = 1;
+
+/*
+ * Tasks are also hashed on their pid, for find_empty_process() and
+ * whoever else needs to find a task by pid.
+ */
+/* 񻹰̺ɢУfind_empty_process()Ȱ̺Ų	*/
+#define PIDHASH_SZ 128
+#define pid_hashfn(x) ((x) & (PIDHASH_SZ - 1))
+
+static struct task_struct *pidhash[PIDHASH_SZ];
+
+static int get_task_nr(void)
+{
+	int nr;
+
+	if ((nr = free_task))
+		free_task = next_task[nr];
+	else if (task_mark < NR_TASKS)
+		nr = task_mark++;
+	else
+		return -EAGAIN;
+	return nr;
+}
+
+void put_task_nr(int nr)
+{
+	next_task[nr] = free_task;
+	free_task = nr;
+}
+
+struct task_struct * find_task_by_pid(int pid)
+{
+	struct task_struct *p;
+
+	for (p = pidhash[pid_hashfn(pid)]; p; p = p->pid_next)
+		if (p->pid == pid)
+			return p;
+	return NULL;
+}
+
+static void hash_pid(struct task_struct * p)
+{
+	p->pid_next = pidhash[pid_hashfn(p->pid)];
+	pidhash[pid_hashfn(p->pid)] = p;
+}
+
+void unhash_pid(struct task_struct * p)
+{
+	struct task_struct **pp;
+
+	for (pp = &pidhash[pid_hashfn(p->pid)]; *pp; pp = &(*pp)->pid_next)
+		if (*pp == p) {
+			*pp = p->pid_next;
+			return;
+		}
+}
+
 /* ̿ռдǰ֤
 80386 CPU,ִȨ0ʱûռеҳǷҳģ
 ִں˴ʱûռҳ汣־ãдʱƻҲʧȥá
@@ -72,12 +139,12 @@ void verify_area(void * addr,int size)
 }
 
 /* ڴҳ
-nrţpݽṹָ롣úΪԵַռô
+dirҳĿ¼pݽṹָ롣úΪԵַռô
 κݶλַ޳ҳLinuxϵͳдʱƣcopy on write
 Ϊ½ԼҳĿ¼ҳûʵΪ½̷
 ڴҳ档ʱ½丸̹ڴҳ档ɹ0򷵻سš
 */
-int copy_mem(int nr,struct task_struct * p)
+int copy_mem(unsigned long dir,struct task_struct * p)
 {
 	unsigned long old_data_base,new_data_base,data_limit;
 	unsigned long old_code_base,new_code_base,code_limit;
@@ -96,20 +163,19 @@ get_limit()
 		panic("We don't support separate I&D");
 	if (data_limit < code_limit)					/* ݶγ < γҲԡ	*/
 		panic("Bad data_limit");
-/* Ȼôе½ԵַռеĻַڣ64MB *ţøֵ
-½ֲ̾жеĻַ½̵ҳĿ¼ҳ
-Ƶǰ̣̣ҳĿ¼ҳʱӽ̵̹ڴҳ档
-copypagetablesO0ʾͷŸҳ
+/* Ȼôе½ԵַռеĻַÿͬԼҳĿ¼У
+øֵ½ֲ̾жеĻַ½̵ҳĿ¼ҳĿ¼
+ҳƵǰ̣̣ҳĿ¼ҳʱӽ̵̹
+ҳ档copypagetablesO0ʾѸƵҳɵҳĿ¼
+һͷš
 */
-	new_data_base = new_code_base = nr * 0x4000000;	/* »ַ=*64Mb(С)	*/
+	new_data_base = new_code_base = USER_BASE;
 	p->start_code = new_code_base;
+	p->tss.cr3 = dir;								/* лʱCPU TSS мcr3	*/
 	set_base(p->ldt[1],new_code_base);				/* ôлַ	*/
 	set_base(p->ldt[2],new_data_base);				/* ݶлַ	*/
-	if (copy_page_tables(old_data_base,new_data_base,data_limit))
-	{												/* ƴݶΡ	*/
-		free_page_tables(new_data_base,data_limit);	/* ͷڴ档	*/
-		return -ENOMEM;
-	}
+	if (copy_page_tables(old_data_base,new_data_base,data_limit,dir))
+		return -ENOMEM;								/* ƴݶΡ	*/
 	return 0;
 }
 
@@ -133,22 +199,31 @@ get_limit()
 вnrǵfindemptyprocess()š
 */
 
-int copy_process(int nr,long ebp,long edi,long esi,long gs,long none,
+int copy_process(int vfork,int nr,long ebp,long edi,long esi,long gs,long none,
 		long ebx,long ecx,long edx,
 		long fs,long es,long ds,
 		long eip,long cs,long eflags,long esp,long ss)
 {
 	struct task_struct *p;
 	int i;
+	unsigned long dir;
+	long pid = last_pid;	/* get_free_page() may sleep, and another fork() move last_pid on */
 	struct file *f;
 
 /* Ϊݽṹڴ档ڴ򷵻س벢˳Ȼ
 ṹָnrСnrΪţǰfindemptyprocess()ء
 ŰѵǰṹݸƵ뵽ڴҳPʼ
 */
-	p = (struct task_struct *) get_free_page();		/* Ϊݽṹڴ档	*/
-	if (!p)											/* ڴ򷵻س벢˳	*/
+	p = (struct task_struct *) get_free_page_noclear();		/* Ϊݽṹڴ档	*/
+	if (!p) {										/* ڴ򷵻س벢˳	*/
+		put_task_nr(nr);
 		return -EAGAIN;
+	}
+	if (!(dir = new_page_dir())) {					/* ΪȡһҳĿ¼	*/
+		put_task_nr(nr);
+		free_page((long) p);
+		return -EAGAIN;
+	}
 	task[nr] = p;									/* ṹָС	*/
 													/* nr Ϊţǰfind_empty_process()ء	*/
 	*p = *current;									/* NOTE! this doesn't copy the supervisor stack */
@@ -160,11 +235,14 @@ int copy_process(int nr,long ebp,long edi,long esi,long gs,long none,
 ں˺û̬ʱͳֵý̿ʼеϵͳʱstarttime
 */
 	p->state = TASK_UNINTERRUPTIBLE;
-	p->pid = last_pid;						/* ½̺šǰfind_empty_process()õ	*/
+	p->pid = pid;							/* ½̺šǰfind_empty_process()õ	*/
 	p->father = current->pid;				/* ø̺š	*/
 	p->counter = p->priority;				/* ʱƬֵ	*/
 	p->signal = 0;							/* źλͼ0	*/
 	p->alarm = 0;							/* ʱֵδ	*/
+	p->alarm_next = NULL;
+	p->rq = NULL;							/* not on a run queue until we're done */
+	p->rq_next = p->rq_prev = NULL;
 	p->leader = 0;							/* process leadership doesn't inherit */
 											/* ̵쵼Ȩǲܼ̳е */
 	p->utime = p->stime = 0;				/* ʼû̬ʱͺ̬ʱ䡣	*/
@@ -197,7 +275,7 @@ int copy_process(int nr,long ebp,long edi,long esi,long gs,long none,
 	p->tss.ds = ds & 0xffff;
 	p->tss.fs = fs & 0xffff;
 	p->tss.gs = gs & 0xffff;
-	p->tss.ldt = _LDT(nr);				/* nr ľֲѡLDT GDT У	*/
+	p->tss.ldt = _LDT(0);				/* ʵʵLDT ѡschedule()лʱá	*/
 	p->tss.trace_bitmap = 0x80000000;	/* ( 16 λЧ)	*/
 
 /* ǰʹЭͱġָcitsƼĴCR0
@@ -214,12 +292,23 @@ int copy_process(int nr,long ebp,long edi,long esi,long gs,long none,
 ޳ҳֵ0λӦͷΪ
 ṹڴҳ
 */
-	if (copy_mem(nr,p))
+	p->vfork_dir = 0;
+	init_waitqueue_head(&p->vfork_wait);
+	if (vfork)
+		p->vfork_dir = dir;
+	else if (copy_mem(dir,p))
 	{									/* زΪ0 ʾ	*/
 		task[nr] = NULL;
+		put_task_nr(nr);
+		free_page_dir(dir);
 		free_page((long) p);
 		return -EAGAIN;
 	}
+	p->nr = nr;
+	hash_pid(p);
+	p->p_pptr = current;
+	p->p_cptr = NULL;
+	SET_LINKS(p);
 /* ļǴ򿪵ģ򽫶ӦļĴ򿪴1Ϊﴴӽ
 븸̹Щ򿪵ļǰ̣̣pwdrootexecutable
 ô1ͬĵӽҲЩiڵ㡣
@@ -233,37 +322,58 @@ int copy_process(int nr,long ebp,long edi,long esi,long gs,long none,
 	if (current->root)
 		current->root->i_count++;
 	if (current->executable)
+	{
 		current->executable->i_count++;
-/* GDTTSSκLDTε޳ó104
-ڡsettssdesc()setldtdesc()Ķμ include/asm/system.h 
-5266к롣gdt+(nr?l)+FIRSTTSSENTRYnrTSSȫ
-еĵַΪÿռGDT2ʽҪnr?l
-Ȼ½óɾ̬лʱĴtrCPUԶء
-󷵻½̺š
+		link_executable(p);
+	}
+	for (i=0; i<NR_MMAP; i++)
+		if (p->mmap[i].vm_inode)
+		{
+			p->mmap[i].vm_inode->i_count++;
+			link_mapping(&p->mmap[i],p);
+		}
+/* TSS LDT schedule()лʱãֻ½ó
+̬󷵻½̺š
 */
-	set_tss_desc(gdt+(nr<<1)+FIRST_TSS_ENTRY,&(p->tss));
-	set_ldt_desc(gdt+(nr<<1)+FIRST_LDT_ENTRY,&(p->ldt));
-	p->state = TASK_RUNNING;		/* do this last, just in case */
+	wake_up_process(p);				/* do this last, just in case */
 									/* ٽóɿ״̬Էһ */
-	return last_pid;				/* ½̺ţǲͬģ	*/
+/* vfork(): the child runs in our address space, so we sleep until it
+ * has exec'ed or exited. */
+	if (vfork)
+	{
+		while (p->vfork_dir)
+			sleep_on(&p->vfork_wait);
+		return pid;
+	}
+	return p->pid;					/* ½̺ţǲͬģ	*/
+}
+
+/*
+ * A vfork() child lets go of its parent's address space on exec or exit:
+ * it moves to its own (empty) page directory, and the parent is woken up.
+ * p is always current.
+ */
+void release_vfork(struct task_struct * p)
+{
+	if (!p->vfork_dir)
+		return;
+	p->tss.cr3 = p->vfork_dir;
+	load_cr3(p->vfork_dir);
+	p->vfork_dir = 0;
+	wake_up(&p->vfork_wait);
 }
 
 /* Ϊ½ȡòظĽ̺last_pidе(index)	*/
 int find_empty_process(void)
 {
-	int i;
 /* ȻȡµĽ̺šlastpid1󳬳̺ŵʾΧ´1ʼ
-ʹpidšȻõpidǷѾκʹá
-תʼ»һpidšΪѰһ
-šlastpidһȫֱ÷ءʱ64Ѿȫ
-ռã򷵻س롣
+ʹpidšȻڽ̺ɢбвҸõpidǷѾκʹá
+תʼ»һpidšŴӿΪȡһţ
+ظúšlastpidһȫֱ÷ءʱѾȫռã
+򷵻س롣ȡõfork ʧcopy_process()黹
 */
 	repeat:
 		if ((++last_pid)<0) last_pid=1;
-		for(i=0 ; i<NR_TASKS ; i++)
-			if (task[i] && task[i]->pid == last_pid) goto repeat;
-	for(i=1 ; i<NR_TASKS ; i++)		/* 0 ų⡣	*/
-		if (!task[i])
-			return i;
-	return -EAGAIN;
+		if (find_task_by_pid(last_pid)) goto repeat;
+	return get_task_nr();
 }
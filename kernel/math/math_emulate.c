@@ -58,5 +58,8 @@ math_error (void)
 	__asm__ ("fnclex");
 /* ϸʹùЭϸЭ쳣źš	*/
 	if (last_task_used_math)
+	{
 		last_task_used_math->signal |= 1 << (SIGFPE - 1);
+		signal_wake_up (last_task_used_math);
+	}
 }
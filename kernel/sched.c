@@ -43,13 +43,13 @@ void show_task (int nr, struct task_struct *p)
 }
 
 /* ʾš̺š״̬ں˶ջֽԼ	*/
-/* NRTASKSϵͳɵ()(64)include/kernel/sched.h4С	*/
+/* NRTASKSϵͳɵ()(512)include/kernel/sched.h4С	*/
 void
 show_stat (void)
 {
 	int i;
 
-	for (i = 0; i < NR_TASKS; i++)	/* NR_TASKS ϵͳɵ̣64 	*/
+	for (i = 0; i < NR_TASKS; i++)	/* NR_TASKS ϵͳɵ̣512 	*/
 		if (task[i])				/* include/kernel/sched.h 4 С	*/
 			show_task (i, task[i]);
 }
@@ -140,6 +140,198 @@ math_state_restore ()
 		}
 }
 
+/*
+ * Runnable tasks are kept on run queues indexed by their counter, with
+ * a bitmap of the non-empty levels, so picking the next task doesn't
+ * mean looking at every task slot. Counters above NR_PRIO-1 all share
+ * the top level.
+ *
+ * A task whose counter has run out goes on the 'expired' queues, with
+ * the counter it will get at the next recalculation (counter/2+priority
+ * with counter 0, ie priority). When the active queues run dry the two
+ * sets are swapped and sched_epoch is bumped. Tasks that were asleep
+ * catch up on the recalculations they missed when they are woken up, so
+ * sleepers still come back with a higher counter than CPU hogs.
+ */
+/*
+ * еcounter ֵڸжϣһλͼ¼ǿյļ
+ * ѡһʱز鿴ÿۡcounter NR_PRIO-1 񶼷
+ * һ
+ *
+ * ʱƬŵ'expired'ϣcounter Ϊһ¼ʱõֵ
+ * (counter Ϊ0 ʱcounter/2+prioritypriority)Ϊʱ
+ * Уsched_epoch 1˯еڱʱϴ¼㣬
+ * ˯߹ԱһֱռCPU øcounter ֵ
+ */
+#define NR_PRIO 32
+
+struct run_queue
+{
+	unsigned long bitmap;					/* ǿռλͼ	*/
+	struct task_struct *queue[NR_PRIO];		/* ѭ˫	*/
+};
+
+static struct run_queue run_queues[2];
+static struct run_queue *active = run_queues;
+static struct run_queue *expired = run_queues + 1;
+static unsigned long sched_epoch = 0;
+
+/*
+ * The GDT only has two TSS/LDT pairs. The running task owns the one
+ * numbered tss_slot, so the other is free to be pointed at the next task.
+ */
+/* GDT ֻTSS/LDT ǰռñΪtss_slot һԣһԿָһ	*/
+static int tss_slot = 0;
+
+/* p жrq counter ӦĶβ	*/
+static inline void
+enqueue_task (struct task_struct *p, struct run_queue *rq)
+{
+	struct task_struct *head;
+	int level = p->counter < NR_PRIO ? p->counter : NR_PRIO - 1;
+
+	p->rq = rq;
+	p->rq_level = level;
+	if (!(head = rq->queue[level]))
+	{
+		rq->queue[level] = p->rq_next = p->rq_prev = p;
+		rq->bitmap |= 1 << level;
+		return;
+	}
+	p->rq_next = head;
+	p->rq_prev = head->rq_prev;
+	head->rq_prev->rq_next = p;
+	head->rq_prev = p;
+}
+
+/* p ڵжȡ¡	*/
+static inline void
+dequeue_task (struct task_struct *p)
+{
+	struct run_queue *rq = p->rq;
+	int level = p->rq_level;
+
+	if (p->rq_next == p)
+	{
+		rq->queue[level] = NULL;
+		rq->bitmap &= ~(1 << level);
+	}
+	else
+	{
+		p->rq_next->rq_prev = p->rq_prev;
+		p->rq_prev->rq_next = p->rq_next;
+		if (rq->queue[level] == p)
+			rq->queue[level] = p->rq_next;
+	}
+	p->rq = NULL;
+	p->rq_next = p->rq_prev = NULL;
+}
+
+/*
+ * Put a runnable task on the queue it belongs to, first applying the
+ * counter recalculations it slept through. Interrupts must be off.
+ */
+/* ѿжУȲ˯ڼcounter ¼㡣
+ * ʱѹжϡ	*/
+static void
+queue_task (struct task_struct *p)
+{
+	unsigned long missed;
+	long c;
+
+	if ((long) (p->rq_epoch - sched_epoch) > 0)
+	{
+		enqueue_task (p, expired);
+		return;
+	}
+	for (missed = sched_epoch - p->rq_epoch; missed; missed--)
+	{
+		c = (p->counter >> 1) + p->priority;
+		if (c == p->counter)
+			break;
+		p->counter = c;
+	}
+	p->rq_epoch = sched_epoch;
+	if (p->counter > 0)
+	{
+		enqueue_task (p, active);
+		return;
+	}
+	p->counter = p->priority;
+	p->rq_epoch = sched_epoch + 1;
+	enqueue_task (p, expired);
+}
+
+/*
+ * wake_up_process() is the one way to make a task runnable: it sets the
+ * state and puts the task on a run queue if it isn't on one already.
+ */
+/* pΪ״̬жжС	*/
+void
+wake_up_process (struct task_struct *p)
+{
+	unsigned long flags;
+
+	if (!p || p->state == TASK_ZOMBIE)
+		return;
+	save_flags (flags);
+	cli ();
+	p->state = TASK_RUNNING;
+	if (!p->rq && p != task[0])
+		queue_task (p);
+	restore_flags (flags);
+}
+
+/*
+ * Called after setting a signal bit in another task: if it sleeps
+ * interruptibly and the signal isn't blocked, wake it up.
+ */
+/* źźãڿж˯״̬źδ	*/
+void
+signal_wake_up (struct task_struct *p)
+{
+/* '~(_BLOCKABLE & p->blocked)'ںԱźţSIGKILL SIGSTOP ܱ	*/
+	if (p->state == TASK_INTERRUPTIBLE &&
+		(p->signal & ~(_BLOCKABLE & p->blocked)))
+		wake_up_process (p);
+}
+
+/*
+ * Pending alarms are kept on a list sorted by expiry time, so the timer
+ * interrupt only has to look at its head.
+ */
+/* ˱ʱֵ񰴵ʱһʱжֻͷ	*/
+static struct task_struct *alarm_list = NULL;
+
+/* p ıʱֵ(δ)expires Ϊ0 ʾȡ	*/
+void
+set_alarm (struct task_struct *p, long expires)
+{
+	struct task_struct **pp;
+	unsigned long flags;
+
+	save_flags (flags);
+	cli ();
+	if (p->alarm)
+		for (pp = &alarm_list; *pp; pp = &(*pp)->alarm_next)
+			if (*pp == p)
+			{
+				*pp = p->alarm_next;
+				break;
+			}
+	p->alarm = expires;
+	p->alarm_next = NULL;
+	if (expires)
+	{
+		for (pp = &alarm_list; *pp && (*pp)->alarm <= expires;
+			 pp = &(*pp)->alarm_next)
+			;
+		p->alarm_next = *pp;
+		*pp = p;
+	}
+	restore_flags (flags);
+}
+
 /*
  * 'schedule()' is the scheduler function. This is GOOD CODE! There
  * probably won't be any reason to change this, as it should work well
@@ -160,65 +352,58 @@ math_state_restore ()
 void
 schedule (void)
 {
-	int i, next, c;
-	struct task_struct **p;				/* ṹָָ롣	*/
-	/* check alarm, wake up any interruptible tasks that have got a signal */
-	/* alarm̵ıʱֵκѵõźŵĿж */
+	struct task_struct *next;
+	unsigned long flags;
+	int level;
 
-	/* һʼalarm	*/
-	for (p = &LAST_TASK; p > &FIRST_TASK; --p)
-		if (*p)
-		{
-/* ùĶʱֵalarmѾ(alarmjiffiesźλͼSIGALRM
-źţSIGALARMźšȻalarmźŵĬϲֹ̡jiffies
-ϵͳӿʼĵδ10ms/δ𣩡sched.h139С	*/
-			if ((*p)->alarm && (*p)->alarm < jiffies)
-			{
-				(*p)->signal |= (1 << (SIGALRM - 1));
-				(*p)->alarm = 0;
-			}
-	/* źλͼгź⻹źţڿж״̬Ϊ״̬	*/
-	/* '~(_BLOCKABLE & (*p)->blocked)'ںԱźţSIGKILL SIGSTOP ܱ	*/
-	if (((*p)->signal & ~(_BLOCKABLE & (*p)->blocked)) &&
-			(*p)->state == TASK_INTERRUPTIBLE)
-		(*p)->state = TASK_RUNNING;		/*ΪִУ״̬	*/
-		}
+	save_flags (flags);
+	cli ();
+/* Alarms and signals sent to sleepers are handled where they happen;
+ * here we only have to catch a signal that arrived before current went
+ * to sleep. Then requeue current, whose counter may have changed. */
+/* ͷ˯źŶڷʱֻ账ǰ˯ǰյ
+ * źšȻ󰴵ǰµcounter ֵ·жС	*/
+	if (current != task[0])
+	{
+		if (current->state == TASK_INTERRUPTIBLE &&
+			(current->signal & ~(_BLOCKABLE & current->blocked)))
+			current->state = TASK_RUNNING;
+		if (current->rq)
+			dequeue_task (current);
+		if (current->state == TASK_RUNNING)
+			queue_task (current);
+	}
 
 	/* this is the scheduler proper: */
 	/* ǵȳҪ */
 
-	while (1)
-		{
-			c = -1;
-			next = 0;
-			i = NR_TASKS;
-			p = &task[NR_TASKS];
-			/* δҲǴһʼѭۡȽÿ	*/
-			/* ״̬counterʱĵݼδֵһֵʱ仹next 	*/
-			/* ָĸš	*/
-			while (--i)
+/* Ϊնexpired вʱпʱƬ꣬У
+ * ൱ڶÿ¼counter = counter /2 + priorityûпеʱ0	*/
+	if (!active->bitmap && expired->bitmap)
 	{
-		if (!*--p)
-			continue;
-		if ((*p)->state == TASK_RUNNING && (*p)->counter > c)
-			c = (*p)->counter, next = i;
-	}
-/* Ƚϵócounterֵ0Ľϵͳûһеڣʱc
-ȻΪ-1neXt=0˳124пʼѭִ141ϵл͸
-ÿȨֵÿһcounterֵȻص125±Ƚϡcounterֵ
-ļ㷽ʽΪcounter = counter /2 + priorityע⣬̲ǽ̵״̬	*/
-			if (c)
-				break;
-			for (p = &LAST_TASK; p > &FIRST_TASK; --p)
-				if (*p)
-					(*p)->counter = ((*p)->counter >> 1) + (*p)->priority;
-		}
-/* ꣨sched.hУѵǰָcurrentָΪnext񣬲л
-С126nextʼΪ0ϵͳûκʱ
-nextʼΪ0˵Ⱥϵͳʱȥִ0ʱ0ִpause()
-IIϵͳãֻñ	*/
+		struct run_queue *tmp = active;
 
-	switch_to (next);					/* лΪnext 񣬲֮	*/
+		active = expired;
+		expired = tmp;
+		sched_epoch++;
+	}
+	next = task[0];
+	if (active->bitmap)
+	{
+		__asm__ ("bsrl %1,%0":"=r" (level):"rm" (active->bitmap));
+		next = active->queue[level];
+	}
+/* ѿеһTSS/LDT ָnextȻ꣨sched.hУѵǰָ
+ * currentָnextлС	*/
+	if (next != current)
+	{
+		tss_slot ^= 1;
+		set_tss_desc (gdt + (tss_slot << 1) + FIRST_TSS_ENTRY, &(next->tss));
+		set_ldt_desc (gdt + (tss_slot << 1) + FIRST_LDT_ENTRY, &(next->ldt));
+		next->tss.ldt = _LDT (tss_slot);
+	}
+	switch_to (next);					/* лnext֮	*/
+	restore_flags (flags);
 }
 
 /* pause()ϵͳáתǰ״̬Ϊжϵĵȴ״̬µȡ
@@ -228,97 +413,133 @@ IIϵͳ
 int
 sys_pause (void)
 {
+/* task 0 pauses whenever there is nothing else to run: use the time to
+ * clear a free page for get_free_page() */
+	if (current == task[0])
+		zero_free_page ();
 	current->state = TASK_INTERRUPTIBLE;
 	schedule ();
 	return 0;
 }
 
-/* ѵǰΪжϵĵȴ״̬˯߶ͷָָǰ
- * ֻȷػʱŻ᷵ءúṩ˽жϴ֮ͬơ
- * Pǵȴͷָ롣ָǺһַıPʹָ
- * ָʽ**PΪCֵֻܴûֱӵķʽñúıøú
- * бֵָ롯*PָĿ꣨ṹı䣬Ϊ޸ĵø
- * ԭֵָҪָ롯*Pָ룬**Pμͼ8-6pָ
- * ʹ
-	*/
+/*
+ * Wait queues. A sleeper puts an entry from its own stack at the tail
+ * of the queue and takes it off again when it runs; wakers only change
+ * task states, so they are safe from interrupts. Interrupts are off
+ * while an entry is linked in or out.
+ */
+/* ȴС˯ߵԼջϵһӵβкٽȡ£
+ * Ѻֻı״̬˿жеáȡ¶ʱжϡ	*/
 void
-sleep_on (struct task_struct **p)
+add_wait_queue (struct wait_queue_head *q, struct wait_queue *wait)
 {
-	struct task_struct *tmp;
+	unsigned long flags;
+
+	save_flags (flags);
+	cli ();
+	wait->next = NULL;
+	if ((wait->prev = q->last))
+		q->last->next = wait;
+	else
+		q->first = wait;
+	q->last = wait;
+	restore_flags (flags);
+}
 
-	/* ָЧ˳ָָĶNULLָ뱾ӦΪ0⣬
-	ǰ0Ϊ0вԼ״̬ں˴0
-	Ϊ˯״̬塣	*/
-	if (!p)
-		return;
-	if (current == &(init_task.task))		/* ǰ0(impossible!)	*/
-		panic ("task[0] trying to sleep");
-/* tmpָѾڵȴϵ(еĻ)inode->iwaitҽ˯߶ͷ
-ĵȴָָǰͰѵǰ뵽 *PĵȴСȻ󽫵ǰ
-Ϊжϵĵȴ״ִ̬µȡ	*/
-	tmp = *p;								/* tmp ָѾڵȴϵ(еĻ)	*/
-	*p = current;							/* ˯߶ͷĵȴָָǰ	*/
-	current->state = TASK_UNINTERRUPTIBLE;	/* ǰΪжϵĵȴ״̬	*/
-	schedule ();							/* µȡ	*/
-	/* ֻеȴ񱻻ʱȳַصʾѱȷػѣ
-	̬ȻҶڵȴͬԴôԴʱбҪеȴԴ
-	Ľ̡úǶ׵ãҲǶ׻еȴԴĽ̡Ƕ׵ָһ
-	̵ sleep_on()ͻڸúблȨתƵСʱ
-	ҲҪʹͬһԴôҲʹͬһȴͷָΪsleep_on()
-	Ҳᡰ롱ú᷵ءֻеںĳԶͷָΪwake_up
-	˸öУôϵͳлȥִͷָָĽAʱý̲Żִ163У
-	кһBλ״̬ѣֵBִʱҲſִܼ
-	163С滹еȴĽCôҲCѵȡ163ǰӦ
-	һ䣺*P = tmp;183ϵĽ͡
-	*/
-	if (tmp)								/* ڵȴҲΪ״̬ѣ	*/
-		tmp->state = 0;
-}
-
-/* ǰΪжϵĵȴ״̬*p ָĵȴСμбsleep_on()˵	*/
 void
-interruptible_sleep_on (struct task_struct **p)
+remove_wait_queue (struct wait_queue_head *q, struct wait_queue *wait)
 {
-	struct task_struct *tmp;
-/* ָЧ˳ָָĶNULLָ뱾Ϊ0ǰ0impossible!	*/
-	if (!p)
+	unsigned long flags;
+
+	save_flags (flags);
+	cli ();
+	if (wait->prev)
+		wait->prev->next = wait->next;
+	else
+		q->first = wait->next;
+	if (wait->next)
+		wait->next->prev = wait->prev;
+	else
+		q->last = wait->prev;
+	restore_flags (flags);
+}
+
+/* ѵǰΪstate ָĵȴ״̬ȴq Уֱȷػѣ߶
+ * жϵĵȴյźţʱŷءѹжϣʱжǹرյġ	*/
+static void
+__sleep_on (struct wait_queue_head *q, long state)
+{
+	struct wait_queue wait;
+	unsigned long flags;
+
+/* ָЧ˳ǰ0Ϊ0вԼ״̬
+ * ں˴0Ϊ˯״̬塣	*/
+	if (!q)
 		return;
 	if (current == &(init_task.task))
 		panic ("task[0] trying to sleep");
-/* tmpָѾڵȴϵ(еĻ)inode->iwaitҽ˯߶ͷ
-ĵȴָָǰͰѵǰ뵽  PĵȴСȻ󽫵ǰ
-Ϊжϵĵȴ״ִ̬µȡ	*/
-	tmp = *p;
-	*p = current;
-repeat:current->state = TASK_INTERRUPTIBLE;
+	wait.task = current;
+/* ״̬УڵǰһֱжϣѺĶǴ˯״̬
+ * ᶪʧѡ	*/
+	save_flags (flags);
+	cli ();
+	current->state = state;
+	add_wait_queue (q, &wait);
 	schedule ();
-/* ֻеȴ񱻻ʱֻ᷵صʾѱȷػѲִС
-ȴлеȴ񣬲Ҷͷָָǵǰʱ򽫸õȴ
-Ϊеľ״ִ̬еȳ򡣵ָ*PָĲǵǰʱ
-ʾڵǰ񱻷кµ񱻲ȴǰȻǣ
-ԼȻȴȴЩе񱻻ִʱѱȥִ
-µȡ	*/
-	if (*p && *p != current)
-		{
-			(**p).state = 0;
-			goto repeat;
-		}
-	/* һӦ*p = tmpöͷָָȴ񣬷ڵǰ֮ǰ	*/
-	/* ȴеĨˡȻͬʱҲɾ192ϵ䡣μͼ4.3	*/
-	*p = NULL;
-	if (tmp)
-		tmp->state = 0;
+	remove_wait_queue (q, &wait);
+	restore_flags (flags);
 }
 
-/**Pָ*Pȴͷָ롣µȴǲڵȴͷָ
-ģ˻ѵȴе	*/
+/* жϵĵȴֻȷػʱŻ᷵ءúṩ˽жϴ֮ͬơ	*/
 void
-wake_up (struct task_struct **p)
+sleep_on (struct wait_queue_head *q)
 {
-	if (p && *p)
+	__sleep_on (q, TASK_UNINTERRUPTIBLE);
+}
+
+/* жϵĵȴѻյźʱأмȴ	*/
+void
+interruptible_sleep_on (struct wait_queue_head *q)
+{
+	__sleep_on (q, TASK_INTERRUPTIBLE);
+}
+
+/*
+ * wake_up() wakes everybody on the queue, for events all of them are
+ * waiting to see (a buffer unlocked, pipe or tty data). wake_up_one()
+ * is for handing out a single resource (a free buffer or request): it
+ * wakes the oldest sleeper that isn't already awake, instead of
+ * letting all of them run just to go back to sleep.
+ */
+/* wake_up()Ѷееȴ߶Ҫ¼ܵն
+ * ݣwake_up_one()ڷ䵥Դлֻѵȴδ
+ * ѵһ񣬶һ˯ߡ	*/
+void
+wake_up (struct wait_queue_head *q)
+{
+	struct wait_queue *wait;
+
+	if (!q)
+		return;
+	for (wait = q->first; wait; wait = wait->next)
+		if (wait->task->state == TASK_UNINTERRUPTIBLE ||
+		    wait->task->state == TASK_INTERRUPTIBLE)
+			wake_up_process (wait->task);	/* ΪУ״̬	*/
+}
+
+void
+wake_up_one (struct wait_queue_head *q)
+{
+	struct wait_queue *wait;
+
+	if (!q)
+		return;
+	for (wait = q->first; wait; wait = wait->next)
+		if (wait->task->state == TASK_UNINTERRUPTIBLE ||
+		    wait->task->state == TASK_INTERRUPTIBLE)
 		{
-			(**p).state = 0;		/* ΪУ״̬	*/
-			*p = NULL;
+			wake_up_process (wait->task);
+			return;
 		}
 }
 
@@ -337,7 +558,7 @@ wake_up (struct task_struct **p)
  * ŵȴתٵĽָ롣0-3ֱӦA-D
 */
 
-static struct task_struct *wait_motor[4] = { NULL, NULL, NULL, NULL };
+static struct wait_queue_head wait_motor[4];
 /* ֱŸҪĵδΪ50δ(0.5룩	*/
 static int mon_timer[4] = { 0, 0, 0, 0 };
 /* ֱŸͣת֮ǰάֵʱ䡣趨Ϊ10000δ(100룩	*/
@@ -543,6 +764,17 @@ do_timer (long cpl)
 	/* ǰ̿FDC Ĵλλģ̶ִʱ(245 )	*/
 	if (current_DOR & 0xf0)
 		do_floppy_timer ();
+/* 򱨾ʱֵѹڵSIGALRM źţ䱨ʱֵ	*/
+	while (alarm_list && alarm_list->alarm <= jiffies)
+	{
+		struct task_struct *p = alarm_list;
+
+		alarm_list = p->alarm_next;
+		p->alarm_next = NULL;
+		p->alarm = 0;
+		p->signal |= (1 << (SIGALRM - 1));
+		signal_wake_up (p);
+	}
 /* ʱ仹û꣬˳õǰмֵΪ0ʱжʱ
 ں˴򷵻أִеȺ	*/
 	if ((--current->counter) > 0)
@@ -568,7 +800,7 @@ sys_alarm (long seconds)
 
 	if (old)
 		old = (old - jiffies) / HZ;
-	current->alarm = (seconds > 0) ? (jiffies + HZ * seconds) : 0;
+	set_alarm (current, (seconds > 0) ? (jiffies + HZ * seconds) : 0);
 	return (old);
 }
 
@@ -628,7 +860,6 @@ sys_nice (long increment)
 void
 sched_init (void)
 {
-	int i;
 	struct desc_struct *p;	/* ṹָ롣	*/
 /* Linuxϵͳ֮ں˲졣ں˴ᱻ޸ġLinusԼ޸Щ
 ؼԵݽṹrosix׼Ĳݡж䲢ޱҪ
@@ -644,17 +875,12 @@ include/asm/system.h
 */
 	set_tss_desc (gdt + FIRST_TSS_ENTRY, &(init_task.task.tss));
 	set_ldt_desc (gdt + FIRST_LDT_ENTRY, &(init_task.task.ldt));
-	/* עi=1 ʼԳʼڣṹļ include/linux/head.h С	*/
-	
+	/* һschedule()ڵһлʱáǾ̬ģѾ㡣	*/
+	/* ṹļ include/linux/head.h С	*/
 	p = gdt + 2 + FIRST_TSS_ENTRY;
-	for (i = 1; i < NR_TASKS; i++)
-		{
-			task[i] = NULL;
-			p->a = p->b = 0;
-			p++;
-			p->a = p->b = 0;
-			p++;
-		}
+	p->a = p->b = 0;
+	p++;
+	p->a = p->b = 0;
 	/* Clear NT, so that we won't have troubles with that later on */
 	/* ־ĴеλNTԺͲ鷳 */
 	/* NT ־ڿƳĵݹ(Nested Task)NT λʱôǰжִ	*/
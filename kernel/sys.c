@@ -232,7 +232,8 @@ sys_brk (unsigned long end_data_seg)
 {
 /* ֵڴβСڣջ-16KBݶνβֵ	*/
 	if (end_data_seg >= current->end_code &&
-			end_data_seg < current->start_stack - 16384)
+			end_data_seg < current->start_stack - 16384 &&
+			end_data_seg <= MMAP_START)
 		current->brk = end_data_seg;
 	return current->brk;					/* ؽ̵ǰݶνβֵ	*/
 }
@@ -256,7 +257,7 @@ sys_brk (unsigned long end_data_seg)
 int
 sys_setpgid (int pid, int pgid)
 {
-	int i;
+	struct task_struct *p;
 /* pid=0ʹõǰ̺špgidΪ0ʹõǰpidΪpgid
  * [P0SIX׼г]	*/
 
@@ -264,22 +265,19 @@ sys_setpgid (int pid, int pgid)
 		pid = current->pid;
 	if (!pgid)									/* pgid Ϊ0ʹõǰpid Ϊpgid	*/
 		pgid = current->pid;					/* [POSIX г]	*/
-/* ɨ飬ָ̺Pidҵ˽̺pidḶ̌ô
+/* ڽ̺ɢбвָ̺Pidҵ˽̺pidḶ̌ô
  * ѾǻỰ죬ءĻỰID뵱ǰ̵ĲͬҲء
  * ý̵pgrp = pgid,0ûҵָpidḶ̌򷵻ؽ̲
  * 롣
 */
-	for (i = 0; i < NR_TASKS; i++)				/* ɨ飬ָ̺ŵ	*/
-		if (task[i] && task[i]->pid == pid)
-			{
-	if (task[i]->leader)						/* Ѿ죬ء	*/
+	if (!(p = find_task_by_pid (pid)))			/* ָ̺ŵ	*/
+		return -ESRCH;
+	if (p->leader)								/* Ѿ죬ء	*/
 		return -EPERM;
-	if (task[i]->session != current->session)	/* ĻỰID	*/
+	if (p->session != current->session)			/* ĻỰID	*/
 		return -EPERM;							/* 뵱ǰ̵Ĳͬء	*/
-	task[i]->pgrp = pgid;						/* øpgrp	*/
+	p->pgrp = pgid;								/* øpgrp	*/
 	return 0;
-			}
-	return -ESRCH;
 }
 
 /* صǰ̵šgetpgid(0)ͬ	*/
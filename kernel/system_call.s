@@ -74,7 +74,7 @@ sa_mask = 4
 sa_flags = 8
 sa_restorer = 12
 
-nr_system_calls = 86  /* 72 */
+nr_system_calls = 93  /* 72 */
 
 /*
  * Ok, I get parallel printer interrupts while using the floppy for some
@@ -82,7 +82,7 @@ nr_system_calls = 86  /* 72 */
  */
 /* ˣʹʱյ˲дӡжϣ֡ǣڲ	*/
 /* ڵ㡣	*/
-.globl _system_call,_sys_fork,_timer_interrupt,_sys_execve
+.globl _system_call,_sys_fork,_sys_vfork,_timer_interrupt,_sys_execve
 .globl _hd_interrupt,_floppy_interrupt,_parallel_interrupt
 .globl _device_not_available, _coprocessor_error
 
@@ -305,8 +305,26 @@ _sys_fork:
 	pushl %edi
 	pushl %ebp
 	pushl %eax
+	pushl $0								/* vfork	*/
 	call _copy_process						/* C copy_process()(kernel/fork.c,68)	*/
-	addl $20,%esp							/* ѹջݡ	*/
+	addl $24,%esp							/* ѹջݡ	*/
+1:	ret
+
+/* sys_vfork()sys_fork()ֻͬӽ̽ø̵ĵַռ䣬˯ߵȴ
+ * ӽִexecve()˳	*/
+.align 2
+_sys_vfork:
+	call _find_empty_process
+	testl %eax,%eax
+	js 1f
+	push %gs
+	pushl %esi
+	pushl %edi
+	pushl %ebp
+	pushl %eax
+	pushl $1
+	call _copy_process
+	addl $24,%esp
 1:	ret
 
 /* int 46 -- (int 0x2E)ӲжϴӦӲжIRQ14
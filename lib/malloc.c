@@ -19,10 +19,11 @@
 * track of how many objects are in use on that page, and the free list
 * for that page. Like the buckets themselves, bucket descriptors are
 * stored on pages requested from get_free_page(). However, unlike buckets,
-* pages devoted to bucket descriptor pages are never released back to the
-* system. Fortunately, a system should probably only need 1 or 2 bucket
-* descriptor pages, since a page can hold 256 bucket descriptors (which
-* corresponds to 1 megabyte worth of bucket pages.) If the kernel is using
+* pages devoted to bucket descriptor pages are only released back to the
+* system by shrink_malloc(), when memory runs low. Fortunately, a system
+* should probably only need 1 or 2 bucket descriptor pages, since a page
+* can hold 169 bucket descriptors (which
+* corresponds to over 600k worth of bucket pages.) If the kernel is using
 * that much allocated memory, it's probably doing something wrong. :-)
 *
 * Note: malloc() and free() both call get_free_page() and free_page()
@@ -61,8 +62,8 @@
 * ÿ洢ͰһΪõĴ洢Ͱм¼ҳжٶ
 * ʹԼҳϿڴб洢Ͱһ洢ͰҲǴ洢ʹ
 * get_free_page()뵽ҳϵģ洢ͰͬǣͰռõҳ
-* ٻͷŸϵͳ˵һϵͳԼֻҪ1 2 ҳͰҳ棬Ϊһ
-* ҳԴ256 Ͱ(Ӧ1MB ڴĴ洢Ͱҳ)ϵͳΪͰ
+* ֻڴ治ʱshrink_malloc()ͷŸϵͳ˵һϵͳԼֻҪ1 
+* 2 ҳͰҳ棬ΪһҳԴ169 Ͱ(Ӧ600 KB ڴĴ洢Ͱҳ)ϵͳΪͰ
 
 * ڴ棬ô϶ϵͳʲôط?
 *
@@ -82,12 +83,17 @@
 #include <linux/kernel.h>				/* ںͷļһЩں˳úԭζ塣	*/
 #include <linux/mm.h>					/* ڴͷļҳСһЩҳͷźԭ͡	*/
 #include <asm/system.h>					/* ϵͳͷļû޸/жŵȵǶʽꡣ	*/
+#include <asm/segment.h>				/* βͷļйضμĴǶʽຯ	*/
+#include <errno.h>						/* ͷļ	*/
+#include <sys/mallstat.h>				/* ںڴͳϢṹ	*/
 
 /* 洢Ͱṹ	*/
 struct bucket_desc
-{										/* 16 bytes */
+{										/* 24 bytes */
 	void *page;							/* ͰӦڴҳָ롣	*/
 	struct bucket_desc *next;			/* һָ롣	*/
+	struct bucket_desc *prev;			/* ǰһָ롣	*/
+	struct bucket_desc *hash_next;		/* ҳɢһָ롣	*/
 	void *freeptr;						/* ָͰпڴλõָ롣	*/
 	unsigned short refcnt;				/* ü	*/
 	unsigned short bucket_size;			/* Ӧ洢ͰĴС	*/
@@ -95,11 +101,38 @@ struct bucket_desc
 
 /* 洢ͰĿ¼ṹ	*/
 struct _bucket_dir
-{										/* 8 bytes */
+{										/* 32 bytes */
 	int size;							/* ô洢ͰĴС(ֽ)	*/
 	struct bucket_desc *chain;			/* ô洢ͰĿ¼Ͱָ롣	*/
+	struct bucket_desc *tail;			/* Ͱһ	*/
+	int pages;							/* ռõҳ	*/
+	int empty;							/* ûжõҳ	*/
+	int inuse;							/* ʹõĶ	*/
+	unsigned long allocs;				/* 	*/
+	unsigned long frees;				/* ͷŴ	*/
 };
 
+/*
+* The first slot of every bucket descriptor page holds this header
+* instead of a descriptor: it links the descriptor pages together and
+* counts the free descriptors on the page, so that shrink_malloc() can
+* tell which pages it may give back.
+*/
+/*
+* ÿͰҳĵһλôŵҳͷ
+* ҳһ𣬲ͳƸҳϿĿԱshrink_malloc()жЩҳ
+* ͷš
+*/
+struct desc_page
+{
+	struct desc_page *next;				/* һҳ档	*/
+	int nr_free;						/* ҳп	*/
+};
+
+#define DESC_PER_PAGE (PAGE_SIZE / sizeof (struct bucket_desc) - 1)
+#define desc_page_of(bdesc) \
+	((struct desc_page *) ((unsigned long) (bdesc) & 0xfffff000))
+
 /*
 * The following is the where we store a pointer to the first bucket
 * descriptor for a given size.
@@ -111,6 +144,10 @@ struct _bucket_dir
 * on this list, some amount of temperance must be exercised here.
 *
 * Note that this list *must* be kept in order.
+*
+* Each chain keeps the descriptors which still have free objects at
+* its head, and the full ones at its tail, so malloc() only ever has
+* to look at the first descriptor.
 */
 /*
 * ǴŵһС洢Ͱָĵط
@@ -118,7 +155,9 @@ struct _bucket_dir
 * Linux ں˷ָСĶôǾϣָĴСӵ
 * б()УΪʹڴķЧǣΪһҳڴҳ
 * бָСжҪĲԲ
-
+*
+* ÿкпжͷβ
+* malloc()ֻ鿴һɡ
 */
 /* 洢ͰĿ¼б()	*/
 struct _bucket_dir bucket_dir[] = {
@@ -142,6 +181,29 @@ struct _bucket_dir bucket_dir[] = {
 */
 struct bucket_desc *free_bucket_desc = (struct bucket_desc *) 0;
 
+/* ͰҳԼҳʹõ	*/
+struct desc_page *desc_page_list = (struct desc_page *) 0;
+int nr_desc_pages = 0;
+int nr_desc_used = 0;
+
+/*
+* Bucket descriptors in use are also hashed on their page, so that
+* free_s() can find the descriptor of an object without searching
+* every chain.
+*/
+/*
+* ʹõͰҳַɢУfree_s()
+* ҵ
+*/
+#define NR_BUCKET_HASH 127
+#define _bhashfn(page) ((((unsigned long) (page)) >> 12) % NR_BUCKET_HASH)
+#define bucket_hash(page) bucket_hash_table[_bhashfn(page)]
+
+struct bucket_desc *bucket_hash_table[NR_BUCKET_HASH];
+
+/* ж󻺴ɵ	*/
+struct kmem_cache *kmem_cache_list = (struct kmem_cache *) 0;
+
 /*
 * This routine initializes a bucket description page.
 */
@@ -153,14 +215,18 @@ struct bucket_desc *free_bucket_desc = (struct bucket_desc *) 0;
 static inline void init_bucket_desc ()
 {
 	struct bucket_desc *bdesc, *first;
+	struct desc_page *dp;
 	int i;
 
 /* һҳڴ棬ڴͰʧܣʾʼͰʱڴ治Ϣ	*/
-	first = bdesc = (struct bucket_desc *) get_free_page ();
-	if (!bdesc)
+	dp = (struct desc_page *) get_free_page ();
+	if (!dp)
 		panic ("Out of memory in init_bucket_desc()");
+/* ҳһλҳͷӵڶλÿʼ	*/
+	first = bdesc = ((struct bucket_desc *) dp) + 1;
+	dp->nr_free = DESC_PER_PAGE;
 /* ȼһҳڴпɴŵͰȻ佨ָ롣	*/
-	for (i = PAGE_SIZE / sizeof (struct bucket_desc); i > 1; i--)
+	for (i = DESC_PER_PAGE; i > 1; i--)
 		{
 			bdesc->next = bdesc + 1;
 			bdesc++;
@@ -177,6 +243,133 @@ static inline void init_bucket_desc ()
 
 	bdesc->next = free_bucket_desc;
 	free_bucket_desc = first;
+	dp->next = desc_page_list;
+	desc_page_list = dp;
+	nr_desc_pages++;
+}
+
+/* ӿͰȡһ	*/
+static inline struct bucket_desc *get_bucket_desc (void)
+{
+	struct bucket_desc *bdesc;
+
+/* free_bucket_desc Ϊʱʾһεøóгʼ	*/
+/* free_bucket_desc ָһͰ	*/
+	if (!free_bucket_desc)
+		init_bucket_desc ();
+/* ȡfree_bucket_desc ָĿͰfree_bucket_desc ָһͰ	*/
+	bdesc = free_bucket_desc;
+	free_bucket_desc = bdesc->next;
+	desc_page_of (bdesc)->nr_free--;
+	nr_desc_used++;
+	return bdesc;
+}
+
+/* ͰŻؿͰ	*/
+static inline void put_bucket_desc (struct bucket_desc *bdesc)
+{
+	bdesc->next = free_bucket_desc;
+	free_bucket_desc = bdesc;
+	desc_page_of (bdesc)->nr_free++;
+	nr_desc_used--;
+}
+
+/*
+* The chain and hash helpers below must be called with interrupts off.
+*/
+/*
+* ɢвڹжϵµá
+*/
+/* ͰĿ¼ɾ	*/
+static inline void remove_from_chain (struct _bucket_dir *bdir,
+									  struct bucket_desc *bdesc)
+{
+	if (bdesc->prev)
+		bdesc->prev->next = bdesc->next;
+	else
+		{
+			if (bdir->chain != bdesc)
+				panic ("malloc bucket chains corrupted");
+			bdir->chain = bdesc->next;
+		}
+	if (bdesc->next)
+		bdesc->next->prev = bdesc->prev;
+	else
+		bdir->tail = bdesc->prev;
+	bdesc->next = bdesc->prev = (struct bucket_desc *) 0;
+}
+
+/* ͷ(пж)	*/
+static inline void insert_chain_head (struct _bucket_dir *bdir,
+									  struct bucket_desc *bdesc)
+{
+	bdesc->prev = (struct bucket_desc *) 0;
+	bdesc->next = bdir->chain;
+	if (bdir->chain)
+		bdir->chain->prev = bdesc;
+	else
+		bdir->tail = bdesc;
+	bdir->chain = bdesc;
+}
+
+/* β()	*/
+static inline void insert_chain_tail (struct _bucket_dir *bdir,
+									  struct bucket_desc *bdesc)
+{
+	bdesc->next = (struct bucket_desc *) 0;
+	bdesc->prev = bdir->tail;
+	if (bdir->tail)
+		bdir->tail->next = bdesc;
+	else
+		bdir->chain = bdesc;
+	bdir->tail = bdesc;
+}
+
+/* ɢбвҳpage ӦͰ	*/
+static inline struct bucket_desc *find_bucket_desc (void *page)
+{
+	struct bucket_desc *bdesc;
+
+	for (bdesc = bucket_hash (page); bdesc; bdesc = bdesc->hash_next)
+		if (bdesc->page == page)
+			return bdesc;
+	return (struct bucket_desc *) 0;
+}
+
+/* ɢбɾͰ	*/
+static inline void remove_from_hash (struct bucket_desc *bdesc)
+{
+	struct bucket_desc **p;
+
+	for (p = &bucket_hash (bdesc->page); *p; p = &(*p)->hash_next)
+		if (*p == bdesc)
+			{
+				*p = bdesc->hash_next;
+				return;
+			}
+	panic ("malloc bucket hash corrupted");
+}
+
+/* ȡͰСΪsize Ĵ洢ͰĿ¼	*/
+static inline struct _bucket_dir *get_bucket_dir (int size)
+{
+	struct _bucket_dir *bdir;
+
+	for (bdir = bucket_dir; bdir->size; bdir++)
+		if (bdir->size == size)
+			return bdir;
+	panic ("malloc bucket size corrupted");
+	return (struct _bucket_dir *) 0;
+}
+
+/* ͷһûжõĴ洢Ͱɢбɾͷҳ档	*/
+static void release_bucket (struct _bucket_dir *bdir, struct bucket_desc *bdesc)
+{
+	remove_from_chain (bdir, bdesc);
+	remove_from_hash (bdesc);
+	free_page ((unsigned long) bdesc->page);
+	put_bucket_desc (bdesc);
+	bdir->pages--;
 }
 
 /* 䶯̬ڴ溯	*/
@@ -209,17 +402,14 @@ void * malloc (unsigned int len)
 			panic ("malloc: bad arg");
 		}
 /*
-* Now we search for a bucket descriptor which has free space
+* Descriptors with free space are kept at the head of the chain, so
+* only the first one needs to be looked at.
 */
 /*
-* ппռͰ
+* ппռͰͷֻ鿴һ
 */
 	cli ();			/* Avoid race conditions Ϊ˱־ȹж */
-/* ӦͰĿ¼ҾппռͰͰĿڴָ	*/
-/* freeptr ΪգʾҵӦͰ	*/
-	for (bdesc = bdir->chain; bdesc; bdesc = bdesc->next)
-		if (bdesc->freeptr)
-			break;
+	bdesc = bdir->chain;
 	/*
 	* If we didn't find a bucket with free space, then we'll
 	* allocate a new one.
@@ -227,27 +417,22 @@ void * malloc (unsigned int len)
 	/*
 	* ûҵппռͰôǾҪ½һĿ¼
 	*/
-	if (!bdesc)
+	if (!bdesc || !bdesc->freeptr)
 	{
 		char *cp;
 		int i;
 
-/* free_bucket_desc Ϊʱʾһεøóгʼ	*/
-/* free_bucket_desc ָһͰ	*/
-		if (!free_bucket_desc)
-			init_bucket_desc ();
-/* ȡfree_bucket_desc ָĿͰfree_bucket_desc ָһͰ	*/
-		bdesc = free_bucket_desc;
-		free_bucket_desc = bdesc->next;
+		bdesc = get_bucket_desc ();
 /* ʼµͰ0ͰĴСڶӦͰĿ¼ĴСһڴҳ棬
  * ҳָpage ָҳ棻ڴָҲָҳͷΪʱȫΪС
  */
 		bdesc->refcnt = 0;
 		bdesc->bucket_size = bdir->size;
-		bdesc->page = bdesc->freeptr = (void *) cp = get_free_page ();
+		cp = (char *) get_free_page ();
 /* ڴҳʧܣʾϢ	*/
 		if (!cp)
 			panic ("Out of memory in kernel malloc()");
+		bdesc->page = bdesc->freeptr = (void *) cp;
 			/* Set up the chain of free objects */
 			/* ڸҳڴнж*/
 /*
@@ -260,117 +445,291 @@ void * malloc (unsigned int len)
 			cp += bdir->size;
 		}
 /* һʼָΪ0(NULL)
- * ȻøͰһֶָָӦͰĿ¼ָchain ָͰĿ¼
- * chain ָͰҲ뵽ͷ
+ * Ȼ󽫸뵽ͷҳַɢб
  */
 		*((char **) cp) = 0;
-		bdesc->next = bdir->chain;	/* OK, link it in!  OK룡 */
-		bdir->chain = bdesc;
+		insert_chain_head (bdir, bdesc);	/* OK, link it in!  OK룡 */
+		bdesc->hash_next = bucket_hash (bdesc->page);
+		bucket_hash (bdesc->page) = bdesc;
+		bdir->pages++;
 	}
+/* ȡõһҳ棬ҳ1	*/
+	else if (!bdesc->refcnt)
+		bdir->empty--;
 /* ָ뼴ڸӦҳĵǰָ롣Ȼÿпռָָһж
  * ʹжӦҳжü1
  */
 	retval = (void *) bdesc->freeptr;
 	bdesc->freeptr = *((void **) retval);
 	bdesc->refcnt++;
+	bdir->inuse++;
+	bdir->allocs++;
+/* ͰƵβú溬пжͷ	*/
+	if (!bdesc->freeptr && bdesc->next)
+	{
+		remove_from_chain (bdir, bdesc);
+		insert_chain_tail (bdir, bdesc);
+	}
 /* 󿪷жϣָڴָ롣	*/
 	sti ();			/* OK, we're safe again  OKְȫ */
 	return (retval);
 }
 
 /*
-* Here is the free routine. If you know the size of the object that you
-* are freeing, then free_s() will use that information to speed up the
-* search for the bucket descriptor.
+* Here is the free routine. The descriptor of the object is found
+* through the page hash, so the size argument is only used as a sanity
+* check.
 *
 * We will #define a macro so that "free(x)" is becomes "free_s(x, 0)"
 */
 /*
-* ͷӳ֪ͷŶĴСfree_s()ʹøϢ
-* ѰӦͰٶȡ
+* ͷӳ򡣶Ͱͨҳɢбң˲size 
+* ϷԼ顣
 *
 * ǽһ꣬ʹ"free(x)"Ϊ"free_s(x, 0)"
 */
-/* ͷŴ洢Ͱ
- * obj - Ӧָ룻
- * size - С
- */
-void free_s (void *obj, int size)
+/*
+* free_object() does the work of free_s() with interrupts already off.
+* A bucket which becomes empty is kept as the spare page of its size
+* class if there is none yet, otherwise its page is released at once.
+*/
+/*
+* free_object()ѹжϵfree_s()ĹյĴ洢ͰǸĿ¼
+* ΨһĿҳãͷҳ档
+*/
+static void free_object (void *obj, int size)
 {
 	void *page;
 	struct _bucket_dir *bdir;
-	struct bucket_desc *bdesc, *prev;
+	struct bucket_desc *bdesc;
+	void *old_free;
 
 	/* Calculate what page this object lives in */
 	/* öڵҳ */
 	page = (void *) ((unsigned long) obj & 0xfffff000);
-	/* Now search the buckets looking for that page */
-	/* 洢ͰĿ¼ӵͰѰҸҳ */
-
-	for (bdir = bucket_dir; bdir->size; bdir++)
-	{
-		prev = 0;
-		/* If size is zero then this conditional is always false */
-		/* size 0϶false */
-		if (bdir->size < size)
-		continue;
-/* ӦĿ¼ӵҶӦҳ档ĳҳָpage ʾҵ
- * ӦתfoundжӦpageָprev ָ
- */
-		for (bdesc = bdir->chain; bdesc; bdesc = bdesc->next)
-		{
-			if (bdesc->page == page)
-				goto found;
-			prev = bdesc;
-		}
-	}
-/* ˶ӦĿ¼ûҵָҳ棬ʾϢ	*/
-	panic ("Bad address passed to kernel free_s()");
-	found:
-/* ҵӦͰȹжϡȻ󽫸öڴпУ
- * ʹĶü1
+/* ɢбвҸҳӦͰûҵ߶СͰĴС
+ * ʾϢ
  */
-	cli ();			/* To avoid race conditions  Ϊ˱⾺ */
+	bdesc = find_bucket_desc (page);
+	if (!bdesc || bdesc->bucket_size < size)
+		panic ("Bad address passed to kernel free_s()");
+	bdir = get_bucket_dir (bdesc->bucket_size);
+/* öڴпУʹĶü1	*/
+	old_free = bdesc->freeptr;
 	*((void **) obj) = bdesc->freeptr;
 	bdesc->freeptr = obj;
 	bdesc->refcnt--;
-/* üѵ0ǾͿͷŶӦڴҳ͸Ͱ	*/
-	if (bdesc->refcnt == 0)
-	{
-			/*
-			* We need to make sure that prev is still accurate. It
-			* may not be, if someone rudely interrupted us....
-			*/
-			/*
-			* Ҫȷprev Ȼȷģĳ³ж
-			* пܲˡ
-			*/
-/* prev Ѿǰһǰǰһ	*/
-		if ((prev && (prev->next != bdesc)) ||
-			(!prev && (bdir->chain != bdesc)))
-		for (prev = bdir->chain; prev; prev = prev->next)
-
-		if (prev->next == bdesc)
-			break;
-/* ҵǰһɾǰ	*/
-		if (prev)
-			prev->next = bdesc->next;
-/* prev==NULL˵ǰһǸĿ¼׸ҲĿ¼chain Ӧֱ
- * ָǰbdescʾ⣬ʾϢˣΪ˽ǰ
- * ɾӦchain ָһ
+	bdir->inuse--;
+	bdir->frees++;
+/* üѵ0ҸĿ¼һҳ棬ͷŶӦڴҳ͸Ͱ
+ * ҳΪҳ档
  */
-		else
+	if (bdesc->refcnt == 0 && bdir->empty)
+		release_bucket (bdir, bdesc);
+	else
+	{
+		if (bdesc->refcnt == 0)
+			bdir->empty++;
+/* Ͱԭ˿ж󣬽Ƶͷ	*/
+		if (!old_free && bdesc->prev)
 		{
-			if (bdir->chain != bdesc)
-				panic ("malloc bucket chains corrupted");
-			bdir->chain = bdesc->next;
+			remove_from_chain (bdir, bdesc);
+			insert_chain_head (bdir, bdesc);
 		}
-/* ͷŵǰڴҳ棬ʼ	*/
-		free_page ((unsigned long) bdesc->page);
-		bdesc->next = free_bucket_desc;
-		free_bucket_desc = bdesc;
 	}
+}
+
+/* ͷŴ洢Ͱ
+ * obj - Ӧָ룻
+ * size - С
+ */
+void free_s (void *obj, int size)
+{
+	cli ();			/* To avoid race conditions  Ϊ˱⾺ */
+	free_object (obj, size);
 /* жϣء	*/
 	sti ();
 	return;
 }
+
+/*
+* Object caches sit on top of malloc(): each one keeps a short list of
+* freed objects of a single type, so the hot kernel objects can be
+* recycled without going through the bucket chains at all. A hit is an
+* allocation served from that list, a miss one that had to go to
+* malloc().
+*/
+/*
+* 󻺴潨malloc()֮ϣÿΪͬһ͵Ķ󱣴һ϶̵ͷ
+* ʹƵʹõں˶辭洢Ͱظʹá(hit)
+* ʾɸ㣬δ(miss)ʾҪmalloc()
+*/
+/* ʼһ󻺴棬뻺
+ * cachep - ṹname - ƣsize - С
+ * max_free - ౣĿж
+ */
+void kmem_cache_init (struct kmem_cache *cachep, char *name,
+					  unsigned int size, int max_free)
+{
+	unsigned long flags;
+
+	if (size > PAGE_SIZE)
+		panic ("kmem_cache_init: object too large");
+	if (size < sizeof (void *))
+		size = sizeof (void *);
+	cachep->name = name;
+	cachep->size = size;
+	cachep->freelist = (void *) 0;
+	cachep->nr_free = 0;
+	cachep->max_free = max_free;
+	cachep->hits = cachep->misses = 0;
+	save_flags (flags);			/* may be called at boot, before sti() */
+	cli ();
+	cachep->next = kmem_cache_list;
+	kmem_cache_list = cachep;
+	restore_flags (flags);
+}
+
+/* Ӷ󻺴зһ	*/
+void * kmem_cache_alloc (struct kmem_cache *cachep)
+{
+	void *obj;
+
+	cli ();
+	if ((obj = cachep->freelist) != (void *) 0)
+	{
+		cachep->freelist = *((void **) obj);
+		cachep->nr_free--;
+		cachep->hits++;
+		sti ();
+		return (obj);
+	}
+	cachep->misses++;
+	sti ();
+	return (malloc (cachep->size));
+}
+
+/* ͷŻض󻺴档еĿжѴޣ򽻻free_s()	*/
+void kmem_cache_free (struct kmem_cache *cachep, void *obj)
+{
+	cli ();
+	if (cachep->nr_free < cachep->max_free)
+	{
+		*((void **) obj) = cachep->freelist;
+		cachep->freelist = obj;
+		cachep->nr_free++;
+		sti ();
+		return;
+	}
+	sti ();
+	free_s (obj, cachep->size);
+}
+
+/*
+* shrink_malloc() is called by the page allocator when free pages run
+* low. It empties the object caches, releases the spare empty bucket
+* pages, and gives back descriptor pages on which no descriptor is in
+* use (keeping one of them). Returns the number of pages freed.
+*/
+/*
+* ҳ治ʱҳshrink_malloc()ո󻺴棬ͷ
+* õĿմ洢Ͱҳ棬ͷûõҳ(һҳ)ͷŵ
+* ҳ
+*/
+int shrink_malloc (int nr)
+{
+	struct kmem_cache *cachep;
+	struct _bucket_dir *bdir;
+	struct bucket_desc *bdesc, *next, **p;
+	struct desc_page *dp, **dpp;
+	unsigned long flags;
+	void *obj;
+	int freed = 0, spare = 0;
+
+	save_flags (flags);
+	cli ();
+/* 󻺴еĶ󽻻洢Ͱ	*/
+	for (cachep = kmem_cache_list; cachep; cachep = cachep->next)
+		while ((obj = cachep->freelist) != (void *) 0)
+		{
+			cachep->freelist = *((void **) obj);
+			cachep->nr_free--;
+			free_object (obj, cachep->size);
+		}
+/* ͷŸĿ¼еĿմ洢Ͱҳ档	*/
+	for (bdir = bucket_dir; bdir->size && freed < nr; bdir++)
+		for (bdesc = bdir->chain; bdesc && bdir->empty; bdesc = next)
+		{
+			next = bdesc->next;
+			if (bdesc->refcnt)
+				continue;
+			release_bucket (bdir, bdesc);
+			bdir->empty--;
+			freed++;
+		}
+/* ͷûõҳ棬һҳ汣ͷš	*/
+	for (dpp = &desc_page_list; (dp = *dpp) && freed < nr;)
+	{
+		if (dp->nr_free != DESC_PER_PAGE || !spare++)
+		{
+			dpp = &dp->next;
+			continue;
+		}
+		for (p = &free_bucket_desc; *p;)
+			if (desc_page_of (*p) == dp)
+				*p = (*p)->next;
+			else
+				p = &(*p)->next;
+		*dpp = dp->next;
+		nr_desc_pages--;
+		free_page ((unsigned long) dp);
+		freed++;
+	}
+	restore_flags (flags);
+	return freed;
+}
+
+/*
+* sys_mallstat() copies one entry per bucket size class to buf, followed
+* by an entry of size 0 for the descriptor pages (pages held, pages with
+* no descriptor in use, descriptors in use). It returns the number of
+* entries copied, at most count.
+*/
+/* ϵͳmallstat()ظ洢ͰĿ¼ͳϢһ(СΪ0)
+ * Ͱҳ档ظƵcount 	*/
+int sys_mallstat (struct mallstat *buf, int count)
+{
+	struct mallstat tmp[NR_MALLSTAT];
+	struct _bucket_dir *bdir;
+	struct desc_page *dp;
+	int i, n = 0;
+
+	if (!buf || count <= 0)
+		return -EINVAL;
+	cli ();
+	for (bdir = bucket_dir; bdir->size && n < NR_MALLSTAT - 1; bdir++, n++)
+	{
+		tmp[n].ms_size = bdir->size;
+		tmp[n].ms_pages = bdir->pages;
+		tmp[n].ms_empty = bdir->empty;
+		tmp[n].ms_inuse = bdir->inuse;
+		tmp[n].ms_allocs = bdir->allocs;
+		tmp[n].ms_frees = bdir->frees;
+	}
+	tmp[n].ms_size = 0;
+	tmp[n].ms_pages = nr_desc_pages;
+	tmp[n].ms_empty = 0;
+	for (dp = desc_page_list; dp; dp = dp->next)
+		if (dp->nr_free == DESC_PER_PAGE)
+			tmp[n].ms_empty++;
+	tmp[n].ms_inuse = nr_desc_used;
+	tmp[n].ms_allocs = tmp[n].ms_frees = 0;
+	n++;
+	sti ();
+	if (n > count)
+		n = count;
+	verify_area (buf, n * sizeof (struct mallstat));
+	for (i = 0; i < n * sizeof (struct mallstat); i++)
+		put_fs_byte (((char *) tmp)[i], i + (char *) buf);
+	return n;
+}
@@ -32,6 +32,7 @@
 *
 * "invalidate()"Ҳ - ⷽһĲ
 */
+#include <sys/mman.h>				/* mmap()ı־PROT_*	*/
 #include <signal.h>					/* źͷļźŷųźŽṹԼźŲԭ͡	*/
 #include <asm/system.h>				/* ϵͳͷļû޸/жŵȵǶʽꡣ	*/
 #include <linux/sched.h>			/* ȳͷļṹtask_structʼ0 ݣ	*/
@@ -51,93 +52,152 @@ static inline volatile void oom (void)
 	printk ("out of memory\n\r");
 	do_exit (SIGSEGV);				/* do_exit()Ӧʹ˳룬źֵSIGSEGV(11)	*/
 }									/* ֵͬĳ뺬ǡԴʱáͬ塣	*/
-/* ˢҳ任ٻ꺯
- * ΪߵַתЧʣCPU ʹõҳݴоƬиٻС޸Ĺҳ
- * Ϣ֮󣬾Ҫˢ¸ûʹ¼ҳĿ¼ַĴcr3 ķˢ¡
- * eax = 0ҳĿ¼Ļַ
- */
-#define invalidate() \
-__asm__( "movl %%eax,%%cr3":: "a" (0))
 
 /* these are not to be changed without changing head.s etc */
 /* 涨ҪĶҪhead.s ļеϢһı */
-/* linux 0.11 ںĬֵ֧ڴ16M޸Щʺϸڴ档	*/
-#define LOW_MEM 0x100000					/* ڴͶˣ1MB	*/
-#define PAGING_MEMORY (15*1024*1024)		/* ҳڴ15MBڴ15M	*/
-#define PAGING_PAGES (PAGING_MEMORY>>12)	/* ҳڴҳ	*/
-#define MAP_NR(addr) (((addr)-LOW_MEM)>>12)	/* ָڴַӳΪҳš	*/
-#define USED 100							/* ҳ汻ռñ־μ405 С	*/
+/* ں˵Եַռ䣨Ҳɹڴ棩Ϊ64M1 ĵַռ䡣	*/
+#define HEAD_MEMORY 0x1000000				/* head.s ҳӳڴ棨16MB	*/
+#define PAGING_PAGES paging_pages			/* ҳڴҳʱȷ	*/
 /* CODE_SPACE(addr) ((((addr)+0xfff)&~0xfff) < current->start_code + current->end_code)	*/
 /* úжϸԵַǷλڵǰ̵ĴУGaddr+4095}&~4095y
  * ȡԵַaddrڴҳĩ˵ַμ252С*/
 #define CODE_SPACE(addr) ((((addr)+4095)&~4095) < \
 current->start_code + current->end_code)
+/* ǰҳĿ¼Եַaddr ӦĿ¼ָ롣	*/
+#define current_pde(addr) pde (current->tss.cr3, addr)
 
-static long HIGH_MEMORY = 0;				/* ȫֱʵڴ߶˵ַ	*/
+unsigned long HIGH_MEMORY = 0;				/* ȫֱʵڴ߶˵ַ	*/
+static unsigned long PAGING_PAGES = 0;
 /* 1 ҳڴ棨4K ֽڣ	*/
 #define copy_page(from,to) \
 __asm__( "cld ; rep ; movsl":: "S" (from), "D" (to), "c" (1024): "cx", "di", "si")
 /* ڴӳֽͼ1ֽڴ1ҳڴ棩ÿҳӦֽڱ־ҳ浱ǰ
- * (ռ)ӳ15Mbڴռ䡣ڳʼmeminit()Уڲ
- * ڴҳλþԤȱóUSED(IOO)
+ * (ռ)ĴСڳʼmeminit()иʵڴȷڴʼ
+ * ڲڴҳλþԤȱóUSED(IOO)
 */
-static unsigned char mem_map[PAGING_PAGES] = { 0, };
+unsigned char * mem_map = NULL;
 
 /*
-* Get physical address of first (actually last :-) free page, and mark it
-* used. If no free pages left, return 0.
-*/
-/* ȡ׸(ʵ1 :-)ҳ棬Ϊʹáûпҳ棬ͷ0*/
+ * A page of zeros (boot/head.s), mapped read-only wherever a process
+ * reads anonymous memory it never wrote. It sits below LOW_MEM, so it
+ * has no count in mem_map: the first write always gets a private copy.
+ */
+extern char empty_zero_page[PAGE_SIZE];
+#define ZERO_PAGE ((unsigned long) empty_zero_page)
+
+/*
+ * Free pages are kept on a list threaded through their first word, so
+ * getting or freeing a page doesn't mean scanning mem_map. mem_map still
+ * holds the reference counts: a page is on the list exactly when its
+ * count is 0. Both ends run with interrupts off, as malloc() relies on
+ * them being safe at interrupt level.
+ */
+/* ҳÿҳĵ1 ִһҳĵַ	*/
+static unsigned long free_page_list = 0;
+unsigned long nr_free_pages = 0;		/* ҳ	*/
+unsigned long min_free_pages = 16;		/* ڴջҳ档	*/
 
-/* ȡҳ档Ѿûпڴˣ򷵻0
- * ڴȡҳ档Ѿûпڴҳ棬򷵻0
- * 룺%l(ax=0) - 0;
- * %2(LOWMEM)ڴֽλͼʼλã
- * %3(cx= PAGINGPAGES);
- * %4(edi=memmap+PAGINGPAGES-l)
- * %0(3=ҳʼַ)
- * %4Ĵʵָmemmapڴֽλͼһֽڡλͼĩ˿ʼ
- * ǰɨҳ־ҳΪPAGINGPAGESҳУڴλͼֽΪ0
- * ҳַע⣡ָֻڴһҳҳ棬ûӳ䵽ĳ
- * ̵ĵַռȥputpageOڰָҳӳ䵽ĳ̵ĵַ
- * ռСȻںʹñҪʹputpageOӳ䣬Ϊں˴
- * ݿռ䣨16MBѾԵȵӳ䵽ַռ䡣
- * 65жһֲĴñeaxĴУԱڸЧʺ
- * ֶķҪǶСϸ˵μgccֲᡰָĴ
- * еı
+/*
+ * The idle task clears free pages ahead of time and keeps them on a
+ * second list, so that get_free_page() seldom has to do it while some
+ * process waits for the page. They count as free pages all the same.
  */
+/* Ŀҳɿ0pause()в䡣	*/
+#define ZERO_POOL 64
+static unsigned long zero_page_list = 0;
+static unsigned long nr_zero_pages = 0;
 
+/*
+ * Take a page off one of the free lists: the zeroed one first if we
+ * want it cleared, the other one first otherwise. Returns 0 (after
+ * trying to swap something out) if both are empty.
+ */
+static unsigned long
+get_page (int clear)
+{
+	unsigned long page, flags;
+	int zeroed;
+
+repeat:
+/* Running low: give back some of the pages the buffer cache took
+ * while memory was plentiful, then the spare pages of malloc(). */
+	if (nr_free_pages < min_free_pages)
+		shrink_buffers(min_free_pages - nr_free_pages);
+	if (nr_free_pages < min_free_pages)
+		shrink_malloc(min_free_pages - nr_free_pages);
+	save_flags(flags);
+	cli();
+	if ((zeroed = (clear || !free_page_list) && zero_page_list)) {
+		page = zero_page_list;
+		zero_page_list = *(unsigned long *) page;
+		nr_zero_pages--;
+	} else if ((page = free_page_list))
+		free_page_list = *(unsigned long *) page;
+	else {
+		restore_flags(flags);
+		if (swap_out())
+			goto repeat;
+		return 0;
+	}
+	if (mem_map[MAP_NR(page)])
+		panic("get_free_page: free page list corrupted");
+	mem_map[MAP_NR(page)] = 1;
+	nr_free_pages--;
+	restore_flags(flags);
+	if (zeroed)
+		*(unsigned long *) page = 0;
+	else if (clear)
+		__asm__("cld ; rep ; stosl"::"a" (0),"D" (page),"c" (1024):"cx","di");
+	return page;
+}
+
+/*
+* Get physical address of a free page, and mark it used. If no free
+* pages left, return 0.
+*/
+/* ȡһҳҳ棬üΪ1ҳ档ûпҳ棬ͷ0	*/
 unsigned long get_free_page(void)
 {
-	register unsigned long __res asm("ax");
-
-	__asm__("std ; repne ; scasb\n\t"
-			"jne 1f\n\t"
-			"movb $1,1(%%edi)\n\t"
-			"sall $12,%%ecx\n\t"
-			"addl %2,%%ecx\n\t"
-			"movl %%ecx,%%edx\n\t"
-			"movl $1024,%%ecx\n\t"
-			"leal 4092(%%edx),%%edi\n\t"
-			"rep ; stosl\n\t"
-			"movl %%edx,%%eax\n"
-			"1:"
-			:"=a" (__res)
-			:"0" (0),"i" (LOW_MEM),"c" (PAGING_PAGES),
-			"D" (mem_map+PAGING_PAGES-1)
-			:"di","cx","dx");
-	return __res;							/* ؿҳַ޿Ҳ򷵻0	*/
+	return get_page(1);
+}
+
+/*
+ * The same, for callers that fill the whole page themselves (copies,
+ * swap and disk reads, task structures): no need to clear it.
+ */
+unsigned long get_free_page_noclear(void)
+{
+	return get_page(0);
+}
+
+/*
+ * Called from the idle loop (task 0 in sys_pause()): clear one page of
+ * the free list and put it on the zeroed one. Only one page at a time,
+ * so that a process that has become runnable doesn't wait long.
+ */
+void zero_free_page(void)
+{
+	unsigned long page, flags;
+
+	if (nr_zero_pages >= ZERO_POOL)
+		return;
+	save_flags(flags);
+	cli();
+	if (!(page = free_page_list)) {
+		restore_flags(flags);
+		return;
+	}
+	free_page_list = *(unsigned long *) page;
+	mem_map[MAP_NR(page)] = 1;
+	restore_flags(flags);
+	__asm__("cld ; rep ; stosl"::"a" (0),"D" (page),"c" (1024):"cx","di");
+	cli();
+	mem_map[MAP_NR(page)] = 0;
+	*(unsigned long *) page = zero_page_list;
+	zero_page_list = page;
+	nr_zero_pages++;
+	restore_flags(flags);
 }
-/* λλal(0)Ӧÿҳ(di)ݱȽϣ	*/
-/* ûе0 ֽڣת0	*/
-/* Ӧҳڴӳλ1	*/
-/* ҳ*4K = ҳʼַ	*/
-/* ټϵͶڴַҳʵʼַ	*/
-/* ҳʵʼַ?edx Ĵ	*/
-/* Ĵecx üֵ1024	*/
-/* 4092+edx λ?edi(ҳĩ)	*/
-/* edi ָڴ㣨Ҳҳ㣩	*/
-/* ҳʼַ?eaxֵ	*/
 
 /*
 * Free a page of memory at physical address 'addr'. Used by
@@ -151,6 +211,8 @@ unsigned long get_free_page(void)
  * addrҪ1MB*/
 void free_page (unsigned long addr)
 {
+	unsigned long flags;
+
 /* жϲַaddrĺԡַaddrСڴͶˣ1MB
  * ʾں˳ٻУԴ˲账ַaddr >=ϵͳ
  * ڴ߶ˣʾϢںֹͣ
@@ -165,12 +227,42 @@ void free_page (unsigned long addr)
  * ֵֽӦΪ0ʾҳͷšӦҳֽԭ0ʾҳ汾
  * ǿеģ˵ں˴⡣ʾϢͣ
  */
-	addr -= LOW_MEM;					/* ַȥͶڴλãٳ4KBҳš	*/
-	addr >>= 12;
-	if (mem_map[addr]--)
-		return;							/* Ӧڴҳӳֽڲ01 ء	*/
-	mem_map[addr] = 0;					/* öӦҳӳֽΪ0ʾϢ	*/
-	panic ("trying to free free page");
+	save_flags (flags);
+	cli ();
+	if (!mem_map[MAP_NR (addr)])		/* ҳ汾ǿеģʾϢ	*/
+	{
+		restore_flags (flags);
+		panic ("trying to free free page");
+	}
+	if (!--mem_map[MAP_NR (addr)])		/* üΪ0ҳŻؿͷ	*/
+	{
+		*(unsigned long *) addr = free_page_list;
+		free_page_list = addr;
+		nr_free_pages++;
+	}
+	restore_flags (flags);
+}
+
+/*
+ * Drop one reference to a page table. The last one also frees the pages
+ * (or swap pages) it maps.
+ */
+static void
+put_table (unsigned long table)
+{
+	unsigned long *pg_table = (unsigned long *) table;
+	int nr;
+
+	if (table < LOW_MEM || mem_map[MAP_NR (table)] == 1)
+		for (nr = 0; nr < 1024; nr++, pg_table++)
+		{
+			if (1 & *pg_table)
+				free_page (0xfffff000 & *pg_table);
+			else if (*pg_table)
+				swap_free (*pg_table >> 1);
+			*pg_table = 0;
+		}
+	free_page (table);
 }
 
 /*
@@ -192,8 +284,7 @@ void free_page (unsigned long addr)
 int
 free_page_tables (unsigned long from, unsigned long size)
 {
-	unsigned long *pg_table;
-	unsigned long *dir, nr;
+	unsigned long *dir;
 
 	if (from & 0x3fffff)				/* Ҫͷڴĵַ4M Ϊ߽硣	*/
 		panic ("free_page_tables called with wrong alignment");
@@ -201,31 +292,129 @@ free_page_tables (unsigned long from, unsigned long size)
 		panic ("Trying to free up swapper memory space");
 /* ռҳĿ¼(4M Ľλ)Ҳռҳ	*/
 	size = (size + 0x3fffff) >> 22;
-/* һʼĿ¼ӦĿ¼=from>>22ÿռ4 ֽڣҳĿ¼Ǵ
- * ַ0 ʼʵʵĿ¼ָ=Ŀ¼<<2Ҳ(from>>20)0xffc ȷ
- * Ŀ¼ָ뷶ΧЧ
+/* һʼĿ¼ӦĿ¼=from>>22Ŀ¼ڵǰԼҳĿ¼С
  */
-	dir = (unsigned long *) ((from >> 20) & 0xffc);	/* _pg_dir = 0 */
+	dir = current_pde (from);
 	for (; size-- > 0; dir++)
 	{								/* size ҪͷڴĿ¼	*/
 		if (!(1 & *dir))			/* Ŀ¼Ч(P λ=0)	*/
 			continue;				/* Ŀ¼λ0(P λ)ʾӦҳǷڡ	*/
-		pg_table = (unsigned long *) (0xfffff000 & *dir);	/* ȡĿ¼ҳַ	*/
-		for (nr = 0; nr < 1024; nr++)
-		{							/* ÿҳ1024 ҳ	*/
-			if (1 & *pg_table)		/* ҳЧ(P λ=1)ͷŶӦڴҳ	*/
-				free_page (0xfffff000 & *pg_table);
-			*pg_table = 0;			/* ҳ㡣	*/
-			pg_table++;				/* ָҳһ	*/
-		}
-			free_page (0xfffff000 & *dir);	/* ͷŸҳռڴҳ档ҳ	*/
-									/* ַ1M ڣʲô	*/
-			*dir = 0;				/* ӦҳĿ¼㡣	*/
+/* ҳfork()̹put_table()	*/
+		put_table (0xfffff000 & *dir);
+		*dir = 0;				/* ӦҳĿ¼㡣	*/
 	}
 	invalidate ();					/* ˢҳ任ٻ塣	*/
 	return 0;
 }
 
+/*
+ * Get a page directory for a new task: the kernel part is the same as
+ * in pg_dir, the rest is empty. Returns 0 if out of memory.
+ */
+/* ΪȡһҳĿ¼ں˲pg_dir ͬΪաڴ治ʱ0	*/
+unsigned long
+new_page_dir (void)
+{
+	unsigned long dir;
+	int i;
+
+	if (!(dir = get_free_page ()))
+		return 0;
+	for (i = 0; i < KERNEL_PDES; i++)
+		((unsigned long *) dir)[i] = pg_dir[i];
+	return dir;
+}
+
+/*
+ * Free a page directory with whatever page tables are left in its user
+ * part. Nobody may be running on it any more.
+ */
+/* ͷҳĿ¼ûʣµҳʱûʹøҳĿ¼	*/
+void
+free_page_dir (unsigned long dir)
+{
+	unsigned long *pg;
+	int i;
+
+	pg = (unsigned long *) dir + KERNEL_PDES;
+	for (i = KERNEL_PDES; i < 1024; i++, pg++)
+		if (1 & *pg)
+			put_table (0xfffff000 & *pg);
+	free_page (dir);
+}
+
+/*
+ * Copy the nr first entries of one page table into another, sharing the
+ * pages write-protected between them. Used by copy_page_tables(), and by
+ * unshare_page_table() when a table shared since fork() is written to.
+ */
+static int
+copy_table (unsigned long *from_page_table, unsigned long *to_page_table,
+	    unsigned long nr)
+{
+	unsigned long this_page;
+	unsigned long new_page;
+
+/*ʱڵǰҳʼѭָnrڴҳȡԴҳݣ 
+ǰԴҳûʹãøƸñһλҳR/W־ 
+(λ10)ҳӦڴҳֻȻ󽫸ҳƵĿҳС
+*/
+	for (; nr-- > 0; from_page_table++, to_page_table++)
+	{
+repeat:
+		this_page = *from_page_table;		/* ȡԴҳݡ	*/
+		if (!this_page)						/* ǰԴҳûʹãøơ	*/
+			continue;
+/* A swapped-out page can't be shared: read it back for the parent, and
+ * let the child have the copy on the swap device. */
+		if (!(1 & this_page))
+		{
+			if (!(new_page = get_free_page_noclear ()))
+				return -1;
+			read_swap_page (this_page >> 1, (char *) new_page);
+/* we slept, and the source table may be shared: another sharer can have
+ * swapped the page in meanwhile, freeing the swap page. Start over. */
+			if (*from_page_table != this_page)
+			{
+				free_page (new_page);
+				goto repeat;
+			}
+			*to_page_table = this_page;
+			*from_page_table = new_page | (PAGE_DIRTY | 7);
+			continue;
+		}
+/* λҳR/W ־(0)(U/S λ0R/W ûáU/S 1R/W 0	*/
+/* ôûĴֻܶҳ档U/S R/W λдȨޡ)	*/
+		this_page &= ~2;
+		*to_page_table = this_page;			/* ҳƵĿҳС	*/
+/* ҳָҳĵַ1M ϣҪڴҳӳmem_map[]Ǽ	*/
+/* ҳţΪҳӳӦô	*/
+/*ҳָҳĵַ1MBϣҪڴҳӳmemmap[]
+ǼҳţΪҳӳӦôλ1MB 
+µҳ棬˵ںҳ棬˲Ҫmemmap áΪmemmap  
+ڹڴеҳʹ˶ںƶ0вҵfork() 
+1ʱinit()ڴʱƵҳ滹Ȼں˴ 
+же䲻ִУ0ҳȻʱдֻеfork()ĸ 
+봦ڴҳλô1MBʱŻִСҪڽ̵execveO
+װִ³ʱŻ֡
+180京ԴҳָڴҳҲΪֻΪڿʼ̹ڴˡ 
+1Ҫдͨҳ쳣дΪִдĽ̷ 
+1ҳ¿ҳ棬Ҳдʱƣcopy on write
+*/
+		if (this_page > LOW_MEM)
+		{
+/* ĺԴҳָڴҳҲΪֻΪڿʼ̹ڴˡ	*/
+/* һڴҪдͨҳ쳣дΪִдĽ̷	*/
+/* һҳµĿҳ棬ҲдʱƵĲ	*/
+			*from_page_table = this_page;	/* ԴҳҲֻ	*/
+			this_page -= LOW_MEM;
+			this_page >>= 12;
+			mem_map[this_page]++;
+		}
+	}
+	return 0;
+}
+
 /*
 * Well, here is one of the most complicated functions in mm. It
 * copies a range of linerar addresses by copying only the pages.
@@ -242,6 +431,14 @@ free_page_tables (unsigned long from, unsigned long size)
 * doesn't take any more memory - we don't copy-on-write in the low
 * 1 Mb-range, so the pages can be shared with the kernel. Thus the
 * special case for nr=xxxx.
+*
+* NOTE 3! Otherwise we don't copy the page tables at all: both directory
+* entries point at the same table, write-protected, and whoever writes
+* through it first gets its own copy (see unshare_page_table()). A fork
+* that is followed by exec() never has to look at the entries.
+*
+* NOTE 4! 'from' is in the current page directory, 'to' in 'to_pg_dir',
+* the directory of the new task.
 */
 /*
 * ˣڴmm Ϊӵĳ֮һֻͨڴҳ
@@ -264,11 +461,11 @@ free_page_tables (unsigned long from, unsigned long size)
  * ˺̽ڴֱһִдʱŷµڴҳдʱƻƣ
  */
 int
-copy_page_tables (unsigned long from, unsigned long to, long size)
+copy_page_tables (unsigned long from, unsigned long to, long size,
+		  unsigned long to_pg_dir)
 {
 	unsigned long *from_page_table;
 	unsigned long *to_page_table;
-	unsigned long this_page;
 	unsigned long *from_dir, *to_dir;
 	unsigned long nr;
 
@@ -283,8 +480,8 @@ copy_page_tables (unsigned long from, unsigned long to, long size)
 	if ((from & 0x3fffff) || (to & 0x3fffff))
 		panic ("copy_page_tables called with wrong alignment");
 /* ȡԴַĿĵַĿ¼(from_dir to_dir)μ115 ע͡	*/
-	from_dir = (unsigned long *) ((from >> 20) & 0xffc);	/* _pg_dir = 0 */
-	to_dir = (unsigned long *) ((to >> 20) & 0xffc);
+	from_dir = current_pde (from);
+	to_dir = pde (to_pg_dir, to);
 /* ҪƵڴռõҳҲĿ¼	*/
 	size = ((unsigned) (size + 0x3fffff)) >> 22;
 /*ڵõԴʼĿ¼ָfromdirĿʼĿ¼ָtodirԼҪƵҳ 
@@ -306,6 +503,13 @@ copy_page_tables (unsigned long from, unsigned long to, long size)
 -1ֵ˳
 */
 		from_page_table = (unsigned long *) (0xfffff000 & *from_dir);
+		if (from)
+		{
+			*from_dir &= ~2;
+			*to_dir = *from_dir;
+			mem_map[MAP_NR ((unsigned long) from_page_table)]++;
+			continue;
+		}
 /* ΪĿҳȡһҳڴ棬0 ˵û뵽ڴҳ档ֵ=-1˳	*/
 		if (!(to_page_table = (unsigned long *) get_free_page ()))
 			return -1;							/* Out of memory, see freeing */
@@ -321,49 +525,71 @@ copy_page_tables (unsigned long from, unsigned long to, long size)
 	/* Եǰҳ踴Ƶҳں˿ռ䣬踴ͷ160 ҳҪ	*/
 /* 1 ҳе1024 ҳ档	*/
 		nr = (from == 0) ? 0xA0 : 1024;
-/*ʱڵǰҳʼѭָnrڴҳȡԴҳݣ 
-ǰԴҳûʹãøƸñһλҳR/W־ 
-(λ10)ҳӦڴҳֻȻ󽫸ҳƵĿҳС
-*/
-		for (; nr-- > 0; from_page_table++, to_page_table++)
-		{
-			this_page = *from_page_table;		/* ȡԴҳݡ	*/
-			if (!(1 & this_page))				/* ǰԴҳûʹãøơ	*/
-				continue;
-/* λҳR/W ־(0)(U/S λ0R/W ûáU/S 1R/W 0	*/
-/* ôûĴֻܶҳ档U/S R/W λдȨޡ)	*/
-			this_page &= ~2;
-			*to_page_table = this_page;			/* ҳƵĿҳС	*/
-/* ҳָҳĵַ1M ϣҪڴҳӳmem_map[]Ǽ	*/
-/* ҳţΪҳӳӦô	*/
-/*ҳָҳĵַ1MBϣҪڴҳӳmemmap[]
-ǼҳţΪҳӳӦôλ1MB 
-µҳ棬˵ںҳ棬˲Ҫmemmap áΪmemmap  
-ڹڴеҳʹ˶ںƶ0вҵfork() 
-1ʱinit()ڴʱƵҳ滹Ȼں˴ 
-же䲻ִУ0ҳȻʱдֻеfork()ĸ 
-봦ڴҳλô1MBʱŻִСҪڽ̵execveO
-װִ³ʱŻ֡
-180京ԴҳָڴҳҲΪֻΪڿʼ̹ڴˡ 
-1Ҫдͨҳ쳣дΪִдĽ̷ 
-1ҳ¿ҳ棬Ҳдʱƣcopy on write
-*/
-			if (this_page > LOW_MEM)
-			{
-/* ĺԴҳָڴҳҲΪֻΪڿʼ̹ڴˡ	*/
-/* һڴҪдͨҳ쳣дΪִдĽ̷	*/
-/* һҳµĿҳ棬ҲдʱƵĲ	*/
-				*from_page_table = this_page;	/* ԴҳҲֻ	*/
-				this_page -= LOW_MEM;
-				this_page >>= 12;
-				mem_map[this_page]++;
-			}
-		}
+		if (copy_table (from_page_table, to_page_table, nr))
+			return -1;
 	}
 	invalidate ();								/* ˢҳ任ٻ塣	*/
 	return 0;
 }
 
+/*
+ * Give the directory entry 'dir' a page table of its own, if the one it
+ * points to is still shared with another task since fork(). Returns 0
+ * if out of memory. The old table keeps its entries; they are now
+ * write-protected and their pages counted twice, as after a real copy.
+ */
+static int
+unshare_page_table (unsigned long *dir)
+{
+	unsigned long old, new;
+
+	old = 0xfffff000 & *dir;
+	if (mem_map[MAP_NR (old)] == 1)
+	{
+		*dir |= 2;
+		invalidate ();
+		return 1;
+	}
+	if (!(new = get_free_page ()))
+		return 0;
+	if (copy_table ((unsigned long *) old, (unsigned long *) new, 1024))
+	{
+		put_table (new);
+		return 0;
+	}
+	*dir = new | 7;
+	invalidate ();
+/* we may have slept, and be the last user of the old one by now */
+	put_table (old);
+	return 1;
+}
+
+/*
+ * Free the pages of a page-aligned range of linear addresses, as for
+ * munmap(). Unlike free_page_tables() this leaves the page tables alone.
+ */
+void
+unmap_page_range (unsigned long from, unsigned long size)
+{
+	unsigned long *dir, *pg_table;
+
+	for (; size; from += PAGE_SIZE, size -= PAGE_SIZE)
+	{
+		dir = current_pde (from);
+		if (!(1 & *dir))
+			continue;
+		if (!(2 & *dir) && !unshare_page_table (dir))
+			oom ();
+		pg_table = (unsigned long *) ((0xfffff000 & *dir) + ((from >> 10) & 0xffc));
+		if (1 & *pg_table)
+			free_page (0xfffff000 & *pg_table);
+		else if (*pg_table)
+			swap_free (*pg_table >> 1);
+		*pg_table = 0;
+	}
+	invalidate ();
+}
+
 /*
 * This function puts a page in memory at the wanted address.
 * It returns the physical address of the page gotten, 0 if
@@ -397,10 +623,12 @@ put_page (unsigned long page, unsigned long address)
 ¸pageҳǷѾҳ棬жڴҳӳֽͼmemmap 
 ӦֽǷѾλû跢档	
 */
-	if (page < LOW_MEM || page >= HIGH_MEMORY)
+	if (page == ZERO_PAGE)
+		;
+	else if (page < LOW_MEM || page >= HIGH_MEMORY)
 		printk ("Trying to put page %p at %p\n", page, address);
 /* ҳڴҳӳֽͼûλʾϢ	*/
-	if (mem_map[(page - LOW_MEM) >> 12] != 1)
+	else if (mem_map[(page - LOW_MEM) >> 12] != 1)
 		printk ("mem_map disagrees with %p at %p\n", page, address);
 /*ȻݲָԵַaddressҳĿ¼жӦĿ¼ָ룬ȡ
 ҳַĿ¼ЧP=lָҳڴУȡָҳ 
@@ -408,10 +636,14 @@ put_page (unsigned long page, unsigned long address)
 Ӧ־7 - UserU/SR/WȻ󽫸ҳַŵpagetableСμ115 
 ˵
 */
-	page_table = (unsigned long *) ((address >> 20) & 0xffc);
+	page_table = current_pde (address);
 /* Ŀ¼Ч(P=1)(Ҳָҳڴ)ȡָҳĵַ>page_table	*/
 	if ((*page_table) & 1)
+	{
+		if (!(2 & *page_table) && !unshare_page_table (page_table))
+			return 0;
 		page_table = (unsigned long *) (0xfffff000 & *page_table);
+	}
 	else
 	{
 /* ҳҳʹãڶӦĿ¼Ӧ־7User, U/S, R/WȻ	*/
@@ -425,7 +657,8 @@ put_page (unsigned long page, unsigned long address)
 ͬʱλ3־UAW/RPҳҳеֵԵַλ21  
 λ12ɵ10صֵÿҳ10240 -- 0x3ff
 */
-	page_table[(address >> 12) & 0x3ff] = page | 7;
+/* the zero page is only ever mapped read-only */
+	page_table[(address >> 12) & 0x3ff] = page | ((page == ZERO_PAGE) ? 5 : 7);
 /* no need for invalidate */
 /* Ҫˢҳ任ٻ */
 	return page;			/* ҳַ	*/
@@ -461,13 +694,44 @@ void un_wp_page (unsigned long *table_entry)
 		invalidate ();
 		return;
 	}
+/* the zero page: a cleared page will do, no need to copy it */
+	if (old_page == ZERO_PAGE)
+	{
+		if (!(new_page = get_free_page ()))
+			oom ();
+		if ((*table_entry & 0xfffff001) != (ZERO_PAGE | 1))
+		{
+			free_page (new_page);	/* ˯ڼѸı䣬ȱҳ·	*/
+			return;
+		}
+		*table_entry = new_page | 7;
+		invalidate ();
+		return;
+	}
 /*ҪڴһҳҳִдĽ̵ʹãȡҳ湲 
 ԭҳڴͶˣζmemmap[] > 1ҳǹģԭҳҳ 
 ӳֵֽݼ1ȻָҳݸΪҳַÿɶдȱ־ 
 (U/SR/WP)ˢҳ任ٻ֮ԭҳݸƵҳϡ
 */
-	if (!(new_page = get_free_page ()))
+	if (!(new_page = get_free_page_noclear ()))
 		oom ();			/* Out of Memoryڴ治	*/
+/* getting the page may have slept: if the entry has changed meanwhile
+ * (the page was swapped out, say), let the fault happen again, and if
+ * the other sharers have gone, the page is ours to write to */
+/* ҳʱ˯ߣ˼Ѹı䣨ҳ汻ͷҳ沢أȱҳ
+ * ·ѾڣֱӰԭҳΪд	*/
+	if ((*table_entry & 0xfffff001) != (old_page | 1))
+	{
+		free_page (new_page);
+		return;
+	}
+	if (old_page >= LOW_MEM && mem_map[MAP_NR (old_page)] == 1)
+	{
+		free_page (new_page);
+		*table_entry |= 2;
+		invalidate ();
+		return;
+	}
 /* ԭҳڴͶˣζmem_map[]>1ҳǹģԭҳҳӳ
  * ֵݼ1ȻָҳݸΪҳĵַÿɶдȱ־(U/S, R/W, P)
  * ˢҳ任ٻ塣ԭҳݸƵҳ档
@@ -527,10 +791,21 @@ address>>22
 ɢҳҳƫƵַϢĿ¼жӦҳַ 
 õҳָ루ַԹҳиơ
 */
-	un_wp_page((unsigned long *)
-	   (((address>>10) & 0xffc) + (0xfffff000 &
-	   *((unsigned long *) ((address>>20) &0xffc)))));
+	unsigned long *dir = current_pde (address);
+	unsigned long *page;
+	struct vm_area *v;
 
+/* mmap()ed read-only: no copy-on-write here */
+	if ((v = find_vma (current, address - current->start_code)) &&
+	    !(v->vm_prot & PROT_WRITE))
+		do_exit (SIGSEGV);
+/* a page table still shared since fork() must be copied first */
+	if (!(2 & *dir) && !unshare_page_table (dir))
+		oom ();
+	page = (unsigned long *) (((address >> 10) & 0xffc) + (0xfffff000 & *dir));
+/* it may have been swapped out while we slept: just fault again */
+	if (1 & *page)
+		un_wp_page (page);
 }
 
 /* дҳ֤	*/
@@ -539,6 +814,13 @@ void
 write_verify (unsigned long address)
 {
 	unsigned long page;
+	struct vm_area *v;
+
+/* the kernel would write a read-only mmap() straight through, present
+ * or not (do_no_page() maps it without R/W), so refuse it here */
+	if ((v = find_vma (current, address - current->start_code)) &&
+	    !(v->vm_prot & PROT_WRITE))
+		do_exit (SIGSEGV);
 /*ȡָԵַӦҳĿ¼Ŀ¼еĴλPжĿ¼Ӧҳ 
 ǷڣλP=l?ڣP=0򷵻ءΪڲڵҳû 
 йдʱƿԣԴ˲ڵҳִдʱϵͳͻΪȱҳ 
@@ -546,8 +828,15 @@ write_verify (unsigned long address)
 ųĿ¼ȡҳַָҳҳеҳƫֵöӦַҳ 
 ָ롣ڸñаŸԵַӦҳ档
 */
-	if (!((page = *((unsigned long *) ((address >> 20) & 0xffc))) & 1))
+	if (!((page = *current_pde (address)) & 1))
 		return;
+/* the kernel ignores the write-protect bit, so copy a shared page table here */
+	if (!(page & 2))
+	{
+		if (!unshare_page_table (current_pde (address)))
+			oom ();
+		page = *current_pde (address);
+	}
 /* ȡҳĵַַָҳҳеҳƫֵöӦҳҳָ롣	*/
 	page &= 0xfffff000;
 	page += ((address >> 10) & 0xffc);
@@ -600,24 +889,49 @@ get_empty_page (unsigned long address)
 õǰP̹֮ͬʱҪָ֤ĵַǷѾҳ棬 
 أ1 -ҳ湲ɹ0 -ʧܡ
 */
+/*
+ * Give linear address 'to_addr' a page table of our own: it may still be
+ * shared since fork(), or missing. Both can sleep, so callers do this
+ * before they look at other tasks at all; share_linear() never sleeps,
+ * and the task and table entry it reads stay valid while it works.
+ */
+/* ΪǰԵַto_addr ׼һԼҳfork()Ա߻ڣ
+ * ˯ߣ˵ڲ鿴֮ǰȵñshare_linear()˯ߡ	*/
+static void
+get_share_table (unsigned long to_addr)
+{
+	unsigned long *dir = current_pde (to_addr);
+	unsigned long tmp;
+
+	if ((*dir & 3) == 1 && !unshare_page_table (dir))
+		oom ();
+	if (*dir & 1)
+		return;
+	if (!(tmp = get_free_page ()))
+		oom ();
+	if (*dir & 1)
+		free_page (tmp);
+	else
+		*dir = tmp | 7;
+}
+
+/*
+ * The work is done on linear addresses, so that mmap() can share pages
+ * that sit at different addresses in the two tasks. from_addr is in the
+ * page directory from_dir, to_addr in ours.
+ */
 static int
-try_to_share (unsigned long address, struct task_struct *p)
+share_linear (unsigned long from_dir, unsigned long from_addr,
+	      unsigned long to_addr)
 {
 	unsigned long from;
 	unsigned long to;
 	unsigned long from_page;
 	unsigned long to_page;
 	unsigned long phys_addr;
-/* ȷֱָPк͵ǰ߼ַaddressӦҳĿ¼Ϊ˼㷽 
-ָ߼ַaddressġ߼ҳĿ¼ţԽ̿ռ䣨0 - 64MBҳ 
-Ŀ¼šá߼ҳĿ¼żϽPCPU 4GԿռʼַӦҳĿ¼ 
-õpеַaddressҳӦ4GԿռеʵҳĿ¼fwmpage 
-߼ҳĿ¼żϵǰCPU 4GԿռʼַӦҳĿ¼ 
-õǰеַaddressҳӦ4GԿռеʵҳĿ¼topage*/
-	from_page = to_page = ((address >> 20) & 0xffc);
-/* p ĴʼַӦҳĿ¼	*/
-	from_page += ((p->start_code >> 20) & 0xffc);		/* PдʼַӦҳĿ¼	*/
-	to_page += ((current->start_code >> 20) & 0xffc);	/* ǰдʼַӦҳĿ¼	*/
+/* ȷֱfrom_addrto_addrӦҳĿ¼	*/
+	from_page = (unsigned long) pde (from_dir, from_addr);
+	to_page = (unsigned long) current_pde (to_addr);
 /* ڵõP̺͵ǰaddressӦĿ¼ֱԽp͵ǰ̽д 
 ȶP̵ıвĿȡPaddressӦڴҳַ 
 ҸҳڣҸɾûб޸Ĺࣩ
@@ -633,7 +947,7 @@ try_to_share (unsigned long address, struct task_struct *p)
 		return 0;
 	from &= 0xfffff000;
 /* ַӦҳֵָȡҳ?phys_addr	*/
-	from_page = from + ((address >> 10) & 0xffc);	/* ҳָ롣	*/
+	from_page = from + ((from_addr >> 10) & 0xffc);	/* ҳָ롣	*/
 	phys_addr = *(unsigned long *) from_page;		/* ҳݡ	*/
 /* is the page clean and present? */
 /* ҳɾҴ*/
@@ -647,24 +961,20 @@ P(PreSent)
 	phys_addr &= 0xfffff000;						/* ҳַ	*/
 	if (phys_addr >= HIGH_MEMORY || phys_addr < LOW_MEM)
 		return 0;
-/* ȶԵǰ̵ıвĿȡõǰaddressӦҳַ
- * Ҹҳûӳҳ棬P=0
- * ȡǰҳĿ¼+toĿ¼ЧP=0Ŀ¼ӦĶҳ
- * ڣһҳҳĿ¼topageݣָڴҳ档
+/* Եǰ̵ıвĿȡõǰaddressӦҳַ
+ * Ҹҳûӳҳ棬P=0ǰԼҳɵ
+ * get_share_table()׼ãû
  */
 	to = *(unsigned long *) to_page;
-	if (!(to & 1))
-		if (to = get_free_page ())
-			*(unsigned long *) to_page = to | 7;
-		else
-			oom ();
+	if ((to & 3) != 3)
+		return 0;
 /* ȡĿ¼еҳ+t0ҳֵ<<2ҳڱƫƵַõ 
  * ҳַ+topageԸҳʱǼӦҳѾڣ
  * ҳĴλP=lBԭ빲PжӦҳ棬Լ 
  * ѾռˣӳУҳ档˵ں˳
 */
 	to &= 0xfffff000;
-	to_page = to + ((address >> 10) & 0xffc);
+	to_page = to + ((to_addr >> 10) & 0xffc);
 	if (1 & *(unsigned long *) to_page)
 		panic ("try_to_share: to_page already exists");
 /* ҵ˽p߼ַaddressӦĸɾҴڵҳ棬Ҳȷ˵ǰ 
@@ -689,13 +999,49 @@ P(PreSent)
 	return 1;
 }
 
+static int
+try_to_share (unsigned long address, struct task_struct *p)
+{
+	return share_linear (p->tss.cr3, p->start_code + address,
+			     current->start_code + address);
+}
+
+/*
+ * Every task with an executable sits on a list headed by that inode's
+ * i_exec, so share_page() only has to look at the tasks that really
+ * run the same file.
+ */
+void
+link_executable (struct task_struct *p)
+{
+	struct m_inode *inode = p->executable;
+
+	p->exec_prev = NULL;
+	if (p->exec_next = inode->i_exec)
+		p->exec_next->exec_prev = p;
+	inode->i_exec = p;
+}
+
+void
+unlink_executable (struct task_struct *p)
+{
+	if (p->exec_next)
+		p->exec_next->exec_prev = p->exec_prev;
+	if (p->exec_prev)
+		p->exec_prev->exec_next = p->exec_next;
+	else
+		p->executable->i_exec = p->exec_next;
+	p->exec_next = p->exec_prev = NULL;
+}
+
 /*
 * share_page() tries to find a process that could share a page with
 * the current one. Address is the address of the wanted page relative
 * to the current data space.
 *
 * We first check if it is at all feasible by checking executable->i_count.
-* It should be >1 if there are other tasks sharing this inode.
+* It should be >1 if there are other tasks sharing this inode. The only
+* candidates are then the tasks on the inode's i_exec list.
 */
 /*
 * share_page()ͼҵһ̣뵱ǰ̹ҳ档address 
@@ -721,7 +1067,7 @@ P(PreSent)
 static int
 share_page (unsigned long address)
 {
-	struct task_struct **p;
+	struct task_struct *p;
 
 /* ȼһµǰ̵executableֶǷָĳִļiڵ㣬жϱ 
  * ǷжӦִļûУ򷵻0executableȷָĳiڵ㣬
@@ -734,26 +1080,84 @@ share_page (unsigned long address)
 /* ִֻܵ(executable->i_count=1)Ҳ˳	*/
 	if (current->executable->i_count < 2)
 		return 0;
-/* Ѱ뵱ǰ̿ɹҳḶִ̌ͬļ 
- * һ̣Զַָҳйҵĳpexecutable 
- * ֵֶ뵱ǰ̵ͬtry_to_shareOҳ湲ɹ 
- * 1򷵻0ʾҳʧܡ
+/* ֻͬһִļḶ̌i_exec Զַָҳ
+ * ɹ1򷵻0ʾҳʧܡ˯ߵ
+ * ҳ׼֮ǰɣı䡣
 */
-	for (p = &LAST_TASK; p > &FIRST_TASK; --p)
+	get_share_table (current->start_code + address);
+	for (p = current->executable->i_exec; p; p = p->exec_next)
 	{
-		if (!*p)						/* УѰҡ	*/
-			continue;
-		if (current == *p)				/* ǵǰҲѰҡ	*/
+		if (current == p)				/* ǵǰҲѰҡ	*/
 			continue;
-		if ((*p)->executable != current->executable)
-/* executableȣʾеĲ뵱ǰִͬļҲѰҡ*/
-			continue;
-		if (try_to_share (address, *p))	/* Թҳ档	*/
+		if (try_to_share (address, p))	/* Թҳ档	*/
 			return 1;
 	}
 	return 0;
 }
 
+/*
+ * Is nothing mapped (or swapped out) at linear address 'address' yet?
+ */
+static int
+page_unmapped (unsigned long address)
+{
+	unsigned long page;
+
+	page = *current_pde (address);
+	if (!(page & 1))
+		return 1;
+	page &= 0xfffff000;
+	return !*(unsigned long *) (page + ((address >> 10) & 0xffc));
+}
+
+/*
+ * Fault in page 'address' (logical tmp) of an mmap()ed file: share it
+ * with another task that has the same part of the file in memory (they
+ * are all on the inode's i_mmap list), or read it. Read-only mappings get a write-protected page, and
+ * do_wp_page() refuses to copy it.
+ */
+static void
+do_mmap_page (struct vm_area *v, unsigned long tmp, unsigned long address)
+{
+	struct m_inode *inode = v->vm_inode;
+	struct vm_area *w;
+	unsigned long pos, page;
+	int nr[4], block, i;
+
+	pos = v->vm_offset + (tmp - v->vm_start);
+	get_share_table (address);
+	for (w = inode->i_mmap; w; w = w->vm_next_share)
+		if (w->vm_task != current && pos >= w->vm_offset &&
+		    pos - w->vm_offset < w->vm_end - w->vm_start &&
+		    share_linear (w->vm_task->tss.cr3, w->vm_task->start_code +
+				  w->vm_start + (pos - w->vm_offset), address))
+			return;
+	if (!(page = get_free_page ()))
+		oom ();
+	block = pos / BLOCK_SIZE;
+	for (i = 0; i < 4; block++, i++)
+		nr[i] = (block * BLOCK_SIZE < inode->i_size) ? bmap (inode, block) : 0;
+	bread_page (page, inode->i_dev, nr);
+/* clear what lies beyond the end of the file */
+	if (pos + PAGE_SIZE > inode->i_size)
+	{
+		i = (pos < inode->i_size) ? inode->i_size - pos : 0;
+		while (i < PAGE_SIZE)
+			((char *) page)[i++] = 0;
+	}
+	if (!put_page (page, address))
+	{
+		free_page (page);
+		oom ();
+	}
+	if (!(v->vm_prot & PROT_WRITE))
+	{
+		page = 0xfffff000 & *current_pde (address);
+		*(unsigned long *) (page + ((address >> 10) & 0xffc)) &= ~2;
+		invalidate ();
+	}
+}
+
 /* Ƿʲҳ洦ҳ쳣жϴеõĺpage.sб 
 error_codeaddressǽڷҳʱCPUȱҳ쳣Զ
 errorcodeָͣμ¿ʼġڴҳ쳣 һڣaddressǲ
@@ -765,15 +1169,39 @@ error
 void
 do_no_page (unsigned long error_code, unsigned long address)
 {
-	int nr[4];
+	int nr[MAX_FAULT_AROUND][4];
+	int win[MAX_FAULT_AROUND];
 	unsigned long tmp;
 	unsigned long page;
-	int block, i;
+	int block, i, j, n, dev;
+	char *p;
+	struct vm_area *v;
 
 	address &= 0xfffff000;	/* ҳַ	*/
+/* A non-zero entry without the present bit is a page out on swap. */
+	page = *current_pde (address);
+	if (page & 1)
+	{
+		page &= 0xfffff000;
+		page += (address >> 10) & 0xffc;
+		if (*(unsigned long *) page && !(1 & *(unsigned long *) page))
+		{
+			if (!swap_in ((unsigned long *) page))
+				oom ();
+			return;
+		}
+	}
 /* ȡԿռַָaddressҳַӶָԵַڽ̿ռ
  * ڽַ̻ƫƳֵtmpӦ߼ַ*/
 	tmp = address - current->start_code;
+/* the mmap() window only has what is mapped there */
+	if (tmp >= MMAP_START && tmp < MMAP_END)
+	{
+		if (!(v = find_vma (current, tmp)))
+			do_exit (SIGSEGV);
+		do_mmap_page (v, tmp, address);
+		return;
+	}
 /* ǰ̵executableڵָգַָ(+)ȣ
  * һҳڴ棬ӳ䵽ָԵַexecutableǽеִļi 
  * ڵṹ01ĴںУ01Լ1 
@@ -785,6 +1213,13 @@ do_no_page (unsigned long error_code, unsigned long address)
  */
 	if (!current->executable || tmp >= current->end_data)
 		{
+/* only reading: map the zero page, and leave the real one to do_wp_page() */
+			if (!(error_code & 2))
+			{
+				if (!put_page (ZERO_PAGE, address))
+					oom ();
+				return;
+			}
 			get_empty_page (address);
 			return;
 		}
@@ -793,39 +1228,78 @@ do_no_page (unsigned long error_code, unsigned long address)
 ãӳ䣩ҳ߼ַtmp	*/
 	if (share_page (tmp))				/* ߼ַtmpҳĹ	*/
 		return;
-/* ȡҳ棬ڴ治ˣʾڴ治ֹ̡	*/
-	if (!(page = get_free_page ()))		/* һҳڴ档	*/
-		oom ();
+/* Fault-around: read the pages that follow in the same go, so that
+ * their blocks are all queued before we wait for any of them. The
+ * window doubles each time a fault lands right where the previous one
+ * ended, ie the program is working through its image in order, and
+ * is halved otherwise. */
+/* Ԥӳ䣺ȱҳʱڼӱ롣	*/
+	if (tmp == current->fault_next)
+	{
+		if ((current->fault_win <<= 1) > MAX_FAULT_AROUND)
+			current->fault_win = MAX_FAULT_AROUND;
+	}
+	else if ((current->fault_win >>= 1) < 1)
+		current->fault_win = 1;
+	for (n = i = 0; i < current->fault_win; i++)
+	{
+		if (tmp + (i << 12) >= current->end_data)
+			break;
+		if (i && (!page_unmapped (address + (i << 12)) ||
+			share_page (tmp + (i << 12))))
+			continue;
+		win[n++] = i;
+	}
+	current->fault_next = tmp + (i << 12);
 /* remember that 1 block is used for header */
 /* סͷҪʹ1 ݿ */
-/* Ϊ豸ϴŵִļӳ1ǳͷṹڶȡļʱҪS 
+/* Ϊ豸ϴŵִļӳ1ǳͷṹڶȡļʱҪ
  * 1ݡҪȼȱҳڵݿšΪÿݳΪBLOCK_SIZE = 1KB
  * һҳڴɴ4ݿ顣߼ַtmpݿСټ1ɵóȱٵҳִ
  * ӳļеʼblockźִļiڵ㣬ǾͿԴӳλͼ
- * Ӧ豸жӦ豸߼ţnr У breadpage()ɰ4
- * ߼뵽ҳpageС	*/
-	block = 1 + tmp / BLOCK_SIZE;			/* 豸϶Ӧ߼š	*/
-/* i ڵϢȡݿ豸ϵĶӦ߼š	*/
-	for (i = 0; i < 4; block++, i++)		/* 豸 4 ߼顣	*/
-		nr[i] = bmap (current->executable, block);
+ * Ӧ豸жӦ豸߼ţnr У	*/
+	dev = current->executable->i_dev;
+	for (j = 0; j < n; j++)
+	{
+		block = 1 + (tmp + (win[j] << 12)) / BLOCK_SIZE;
+		for (i = 0; i < 4; block++, i++)
+		{
+			nr[j][i] = bmap (current->executable, block);
+			if (nr[j][i])
+				bread_ahead (dev, nr[j][i]);
+		}
+	}
+	for (j = 0; j < n; j++)
+	{
+		if (!(page = get_free_page ()))
+		{
+			if (j)
+				return;
+			oom ();
+		}
 /* 豸һҳݣ4 ߼飩ַָpage 	*/
-	bread_page (page, current->executable->i_dev, nr);
+		bread_page (page, dev, nr[j]);
 /* ڶ豸߼ʱܻһִļеĶȡҳλÿ
  * ļβ1ҳĳȡ˾ͿܶһЩõϢĲǰⲿֳ
  * ִļenddataԺĲ㴦	*/
-	i = tmp + 4096 - current->end_data;		/* ֽڳֵ	*/
-	tmp = page + 4096;						/* tmp ָҳĩˡ	*/
-	while (i-- > 0)							/* ҳĩiֽ㡣	*/
-	{
-		tmp--;
-		*(char *) tmp = 0;
-	}
-/* ȱҳ쳣һҳҳӳ䵽ָԵַaddressɹͷء 
- * ͷڴҳʾڴ治	*/
-	if (put_page (page, address))
+		i = tmp + (win[j] << 12) + 4096 - current->end_data;	/* ֽڳֵ	*/
+		p = (char *) page + 4096;				/* p ָҳĩˡ	*/
+		while (i-- > 0)							/* ҳĩiֽ㡣	*/
+			*--p = 0;
+/* ҳӳ䵽ӦԵַȱҳ쳣ҳӳʧܣͷڴҳʾ
+ * ڴ治	*/
+		if (j && !page_unmapped (address + (win[j] << 12)))
+		{
+			free_page (page);
+			continue;
+		}
+		if (put_page (page, address + (win[j] << 12)))
+			continue;
+		free_page (page);
+		if (!j)
+			oom ();
 		return;
-	free_page (page);
-	oom ();
+	}
 }
 
 /* ڴʼ
@@ -852,7 +1326,28 @@ mem_init (long start_mem, long end_mem)
  * ֵֽȫó USED(100)?PAGINGPAGES Ϊ(PAGINGMEM0RY>>12) 1MB 
  * ڴҳڴҳ15MB/4KB = 3840
  */
+	unsigned long addr, *pg_table;
+
 	HIGH_MEMORY = end_mem;				/* ڴ߶ˡ	*/
+	PAGING_PAGES = (end_mem - LOW_MEM) >> 12;
+	if ((min_free_pages = PAGING_PAGES >> 6) < 16)
+		min_free_pages = 16;
+	start_mem = (start_mem + 4095) & ~4095;
+/* head.s only maps the first 16MB: take page tables for the rest from
+ * the start of main memory. The bookkeeping goes there too, with one
+ * byte of mem_map for each page above 1MB. */
+	for (addr = HEAD_MEMORY; addr < end_mem; addr += 0x400000)
+	{
+		pg_table = (unsigned long *) start_mem;
+		start_mem += 4096;
+		for (i = 0; i < 1024; i++)
+			pg_table[i] = (addr + (i << 12) < end_mem) ?
+				(addr + (i << 12)) | 7 : 0;
+		pg_dir[addr >> 22] = ((unsigned long) pg_table) | 7;
+	}
+	invalidate ();
+	mem_map = (unsigned char *) start_mem;
+	start_mem = (start_mem + PAGING_PAGES + 4095) & ~4095;
 	for (i = 0; i < PAGING_PAGES; i++)	/* ҳΪռ(USED=100)״̬	*/
 		mem_map[i] = USED;				/* ҳӳȫóUSED	*/
 /* Ȼڴʼڴ洦ҳӦڴӳֽiڴ
@@ -863,8 +1358,14 @@ mem_init (long start_mem, long end_mem)
 	i = MAP_NR (start_mem);				/* Ȼʹʼڴҳš	*/
 	end_mem -= start_mem;				/* ټɷҳڴС	*/
 	end_mem >>= 12;						/* Ӷڷҳҳ	*/
-	while (end_mem-- > 0)				/* ЩҳӦҳӳ㡣	*/
-		mem_map[i++] = 0;
+	while (end_mem-- > 0)				/* ЩҳӦҳӳ㣬	*/
+	{									/* ҳҳ	*/
+		mem_map[i] = 0;
+		*(unsigned long *) (LOW_MEM + (i << 12)) = free_page_list;
+		free_page_list = LOW_MEM + (i << 12);
+		nr_free_pages++;
+		i++;
+	}
 }
 
 /* ڴҳʾ	*/
@@ -874,6 +1375,7 @@ calc_mem (void)
 {
 	int i, j, k, free = 0;
 	long *pg_tbl;
+	unsigned long *dir = (unsigned long *) current->tss.cr3;
 
 /* ɨڴҳӳmemmap[]ȡҳʾȻɨҳĿ¼0
  * 1ҳĿ¼ЧͳƶӦҳЧҳʾҳĿ¼03ں
@@ -882,11 +1384,12 @@ calc_mem (void)
 	for (i = 0; i < PAGING_PAGES; i++)
 		if (!mem_map[i])
 			free++;
-	printk ("%d pages free (of %d)\n\r", free, PAGING_PAGES);
-/* ɨҳĿ¼01 ҳĿ¼ЧͳƶӦҳЧҳʾ	*/
+	printk ("%d pages free (of %d), %d on free list\n\r", free, PAGING_PAGES,
+		nr_free_pages);
+/* ɨ赱ǰҳĿ¼Ŀ¼01 ҳĿ¼ЧͳƶӦҳЧҳʾ	*/
 	for(i=2 ; i<1024 ; i++) {
-		if (1&pg_dir[i]) {
-			pg_tbl=(long *) (0xfffff000 & pg_dir[i]);
+		if (1&dir[i]) {
+			pg_tbl=(long *) (0xfffff000 & dir[i]);
 			for(j=k=0 ; j<1024 ; j++)
 				if (pg_tbl[j]&1)
 					k++;
@@ -0,0 +1,211 @@
+/*
+ * linux/mm/mmap.c
+ *
+ * mmap() and munmap() for regular files. Nothing is read at mmap() time:
+ * the area is only noted in current->mmap[], and do_no_page() reads the
+ * pages in (or shares them with another task mapping the same part of
+ * the file) as they are touched. Private mappings may be written to, the
+ * changes staying in the task; shared ones are read-only for now, as we
+ * have no way to write the pages back to the file.
+ */
+/*
+ * ʵͨļmmap()munmap()mmap()ʱݣֻcurrent->mmap[]
+ * еǼӳʱdo_no_page()ҳ棬ӳļͬһֵ̹
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include <linux/sched.h>
+#include <linux/kernel.h>
+#include <asm/segment.h>
+
+/* ҽp а߼ַaddr ӳ	*/
+struct vm_area *
+find_vma (struct task_struct *p, unsigned long addr)
+{
+	struct vm_area *v;
+
+	for (v = p->mmap; v < p->mmap + NR_MMAP; v++)
+		if (v->vm_inode && addr >= v->vm_start && addr < v->vm_end)
+			return v;
+	return NULL;
+}
+
+/* [addr,addr+len)صӳ	*/
+static struct vm_area *
+find_overlap (unsigned long addr, unsigned long len)
+{
+	struct vm_area *v;
+
+	for (v = current->mmap; v < current->mmap + NR_MMAP; v++)
+		if (v->vm_inode && v->vm_start < addr + len && v->vm_end > addr)
+			return v;
+	return NULL;
+}
+
+/* ȡһеӳ	*/
+static struct vm_area *
+get_empty_vma (void)
+{
+	struct vm_area *v;
+
+	for (v = current->mmap; v < current->mmap + NR_MMAP; v++)
+		if (!v->vm_inode)
+			return v;
+	return NULL;
+}
+
+/*
+ * Every mapping sits on a list headed by its inode's i_mmap, so that
+ * do_mmap_page() only has to look at the tasks that really map the file.
+ */
+void
+link_mapping (struct vm_area *v, struct task_struct *p)
+{
+	struct m_inode *inode = v->vm_inode;
+
+	v->vm_task = p;
+	v->vm_prev_share = NULL;
+	if ((v->vm_next_share = inode->i_mmap))
+		v->vm_next_share->vm_prev_share = v;
+	inode->i_mmap = v;
+}
+
+void
+unlink_mapping (struct vm_area *v)
+{
+	if (v->vm_next_share)
+		v->vm_next_share->vm_prev_share = v->vm_prev_share;
+	if (v->vm_prev_share)
+		v->vm_prev_share->vm_next_share = v->vm_next_share;
+	else
+		v->vm_inode->i_mmap = v->vm_next_share;
+	v->vm_next_share = v->vm_prev_share = NULL;
+}
+
+/*
+ * Drop all the mappings of task p, on exit() or exec(). The pages
+ * themselves go with the page tables.
+ */
+void
+exit_mmap (struct task_struct *p)
+{
+	struct vm_area *v;
+
+	for (v = p->mmap; v < p->mmap + NR_MMAP; v++)
+		if (v->vm_inode)
+		{
+			unlink_mapping (v);
+			iput (v->vm_inode);
+			v->vm_inode = NULL;
+		}
+}
+
+/* ϵͳmmap()ûռstruct mmap_arg Сӳ߼ַ	*/
+int
+sys_mmap (struct mmap_arg *arg)
+{
+	struct mmap_arg a;
+	struct file *file;
+	struct m_inode *inode;
+	struct vm_area *v;
+	unsigned long addr;
+	int i;
+
+	for (i = 0; i < sizeof (a) / 4; i++)
+		((unsigned long *) &a)[i] = get_fs_long (i + (unsigned long *) arg);
+	if (a.fd >= NR_OPEN || a.fd < 0 || !(file = current->filp[a.fd]))
+		return -EBADF;
+	inode = file->f_inode;
+	if (!S_ISREG (inode->i_mode))
+		return -ENODEV;
+	if ((file->f_flags & O_ACCMODE) == O_WRONLY)
+		return -EACCES;
+	if (!a.len || (a.offset & (PAGE_SIZE - 1)) || a.offset < 0)
+		return -EINVAL;
+	if ((a.flags & (MAP_SHARED | MAP_PRIVATE)) == 0 ||
+	    ((a.flags & MAP_SHARED) && (a.prot & PROT_WRITE)))
+		return -EINVAL;
+	a.len = (a.len + PAGE_SIZE - 1) & 0xfffff000;
+	if (!(v = get_empty_vma ()))
+		return -ENOMEM;
+	if (a.flags & MAP_FIXED)
+	{
+		addr = (unsigned long) a.addr;
+		if ((addr & (PAGE_SIZE - 1)) || addr < MMAP_START ||
+		    addr + a.len > MMAP_END || addr + a.len < addr ||
+		    find_overlap (addr, a.len))
+			return -EINVAL;
+	}
+	else
+	{
+		for (addr = MMAP_START; addr + a.len <= MMAP_END; addr = v->vm_end)
+		{
+			if (!(v = find_overlap (addr, a.len)))
+				break;
+		}
+		if (addr + a.len > MMAP_END || addr + a.len < addr)
+			return -ENOMEM;
+		v = get_empty_vma ();
+	}
+/* whatever is still mapped in the range must go, or it would hide the
+ * file: do_no_page() only reads pages that aren't there */
+	unmap_page_range (current->start_code + addr, a.len);
+	v->vm_start = addr;
+	v->vm_end = addr + a.len;
+	v->vm_offset = a.offset;
+	v->vm_prot = a.prot;
+	v->vm_inode = inode;
+	inode->i_count++;
+	link_mapping (v, current);
+	return addr;
+}
+
+/* ϵͳmunmap()ȡ[addr,addr+len)Χڵӳ䣬ͷеҳ档	*/
+int
+sys_munmap (unsigned long addr, unsigned long len)
+{
+	struct vm_area *v, *n;
+	unsigned long end;
+
+	if ((addr & (PAGE_SIZE - 1)) || !len)
+		return -EINVAL;
+	end = addr + ((len + PAGE_SIZE - 1) & 0xfffff000);
+	if (addr < MMAP_START || end > MMAP_END || end < addr)
+		return -EINVAL;
+	for (v = current->mmap; v < current->mmap + NR_MMAP; v++)
+	{
+		if (!v->vm_inode || v->vm_start >= end || v->vm_end <= addr)
+			continue;
+/* a hole in the middle: the part above it needs a slot of its own */
+		if (v->vm_start < addr && v->vm_end > end)
+		{
+			if (!(n = get_empty_vma ()))
+				return -ENOMEM;
+			*n = *v;
+			n->vm_offset += end - v->vm_start;
+			n->vm_start = end;
+			n->vm_inode->i_count++;
+			link_mapping (n, current);
+			v->vm_end = addr;
+		}
+		else if (v->vm_start < addr)
+			v->vm_end = addr;
+		else if (v->vm_end > end)
+		{
+			v->vm_offset += end - v->vm_start;
+			v->vm_start = end;
+		}
+		else
+		{
+			unlink_mapping (v);
+			iput (v->vm_inode);
+			v->vm_inode = NULL;
+		}
+	}
+	unmap_page_range (current->start_code + addr, end - addr);
+	return 0;
+}
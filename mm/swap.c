@@ -0,0 +1,269 @@
+/*
+ * linux/mm/swap.c
+ *
+ * This implements swapping of user pages to a block device. The swap
+ * device is set like the root device (SWAP_DEV in boot/bootsect.s) and
+ * must carry a "SWAP-SPACE" signature: its first page is a bitmap with
+ * a bit set for each page that may be used, the signature taking the
+ * last 10 bytes of it.
+ */
+/*
+ * ʵְûҳ潻豸ϡ豸豸һboot/bootsect.s ã
+ * 1 ҳǽҳλͼҳӦıλΪ110 ֽ"SWAP-SPACE"
+ * ǩ
+ */
+
+#include <string.h>
+
+#include <linux/mm.h>
+#include <linux/sched.h>
+#include <linux/head.h>
+#include <linux/kernel.h>
+#include <asm/system.h>
+
+#define SWAP_BITS ((PAGE_SIZE - 10) << 3)		/* λͼпõıλ	*/
+#define FIRST_VM_PDE (USER_BASE >> 22)				/* ҳĿ¼ûֵĵ1 	*/
+#define LAST_VM_PDE ((USER_BASE + TASK_SIZE) >> 22)
+#define VM_PAGES (NR_TASKS * (TASK_SIZE >> 12))
+
+/* λԡλλָλԭֵ	*/
+#define bitop(name,op) \
+static inline int name (char *addr, unsigned int nr) \
+{ \
+int __res; \
+__asm__ __volatile__("bt" op " %1,%2; adcl $0,%0" \
+:"=g" (__res) \
+:"r" (nr),"m" (*(addr)),"0" (0)); \
+return __res; \
+}
+
+bitop (bit, "")
+bitop (setbit, "s")
+bitop (clrbit, "r")
+
+int SWAP_DEV = 0;
+static char *swap_bitmap = NULL;
+static int swap_pages = 0;				/* ҳλͼе߿ҳ+1	*/
+
+/*
+ * swap_out() runs one at a time, and the page it is writing stays
+ * marked in swap_writing until the write is done: swap_in() and fork
+ * must not read that page before then.
+ */
+static int swap_lock = 0;
+static int swap_writing = 0;
+static struct wait_queue_head swap_wait;
+
+void
+read_swap_page (int swap_nr, char *buffer)
+{
+	while (swap_writing == swap_nr)
+		sleep_on (&swap_wait);
+	ll_rw_page (READ, SWAP_DEV, swap_nr, buffer);
+}
+
+void
+write_swap_page (int swap_nr, char *buffer)
+{
+	ll_rw_page (WRITE, SWAP_DEV, swap_nr, buffer);
+}
+
+static int
+get_swap_page (void)
+{
+	int nr;
+
+	if (!swap_bitmap)
+		return 0;
+	for (nr = 1; nr < swap_pages; nr++)
+		if (clrbit (swap_bitmap, nr))
+			return nr;
+	return 0;
+}
+
+void
+swap_free (int swap_nr)
+{
+	if (!swap_nr)
+		return;
+	if (swap_bitmap && swap_nr < swap_pages)
+		if (!setbit (swap_bitmap, swap_nr))
+			return;
+	printk ("Swap-space bad (swap_free())\n\r");
+}
+
+/*
+ * Bring back the page table_ptr refers to. Returns 0 if there was no
+ * memory for it.
+ */
+int
+swap_in (unsigned long *table_ptr)
+{
+	int swap_nr;
+	unsigned long page;
+
+	if (!swap_bitmap) {
+		printk ("Trying to swap in without swap bit-map");
+		return 1;
+	}
+	if (PAGE_PRESENT & *table_ptr) {
+		printk ("trying to swap in present page\n\r");
+		return 1;
+	}
+	if (!(swap_nr = *table_ptr >> 1)) {
+		printk ("No swap page in swap_in\n\r");
+		return 1;
+	}
+	if (!(page = get_free_page_noclear ()))
+		return 0;
+	read_swap_page (swap_nr, (char *) page);
+/* we slept: the entry may be gone (exit) or already back (the page was
+ * shared with nobody, but let's not count on it) */
+	if (*table_ptr != (swap_nr << 1)) {
+		free_page (page);
+		return 1;
+	}
+	if (setbit (swap_bitmap, swap_nr))
+		printk ("swapping in multiply from same page\n\r");
+	*table_ptr = page | (PAGE_DIRTY | 7);
+	return 1;
+}
+
+/*
+ * Try to free the page behind one page table entry of linear address
+ * addr in task p. Pages used since we last looked are given another
+ * round, with their accessed bit cleared. Clean pages of a task's
+ * executable or of an mmap()ed file are just dropped, as do_no_page()
+ * can read them again. Anything else that isn't shared goes to the swap
+ * device.
+ */
+static int
+try_to_swap_out (struct task_struct *p, unsigned long *table_ptr,
+		 unsigned long addr)
+{
+	unsigned long page;
+	int swap_nr;
+
+	page = *table_ptr;
+	if (!(PAGE_PRESENT & page))
+		return 0;
+	if (PAGE_ACCESSED & page) {
+		*table_ptr &= ~PAGE_ACCESSED;
+		return 0;
+	}
+	page &= 0xfffff000;
+	if (page < LOW_MEM || page >= HIGH_MEMORY)
+		return 0;
+	if (mem_map[MAP_NR (page)] != 1)
+		return 0;
+	if (!(PAGE_DIRTY & *table_ptr) && ((p->executable &&
+	    addr - p->start_code < p->end_data) ||
+	    find_vma (p, addr - p->start_code))) {
+		*table_ptr = 0;
+		invalidate ();
+		free_page (page);
+		return 1;
+	}
+	if (!(swap_nr = get_swap_page ()))
+		return 0;
+	*table_ptr = swap_nr << 1;
+	invalidate ();
+	swap_writing = swap_nr;
+	write_swap_page (swap_nr, (char *) page);
+	swap_writing = 0;
+	free_page (page);
+	return 1;
+}
+
+/*
+ * Free one user page, going round the address spaces of all tasks like
+ * a clock hand: two rounds are enough to find a page nobody touched in
+ * between, if there is one. Returns 0 if no page could be freed.
+ */
+int
+swap_out (void)
+{
+	static int swap_task = 0;
+	static int dir_entry = FIRST_VM_PDE;
+	static int page_entry = -1;
+	long counter = 2 * VM_PAGES;
+	struct task_struct *p;
+	unsigned long pg_table;
+	int freed = 0;
+
+	while (swap_lock)
+		sleep_on (&swap_wait);
+	swap_lock = 1;
+	while (counter > 0 && !freed) {
+		p = task[swap_task];
+		pg_table = p ? *pde (p->tss.cr3, dir_entry << 22) : 0;
+		if (PAGE_PRESENT & pg_table) {
+			pg_table &= 0xfffff000;
+			while (++page_entry < 1024) {
+				counter--;
+				if (try_to_swap_out (p, (unsigned long *) pg_table + page_entry,
+				    (dir_entry << 22) | (page_entry << 12))) {
+					freed = 1;
+					break;
+				}
+			}
+			if (freed)
+				break;
+		} else
+			counter -= 1024;
+		page_entry = -1;
+		if (++dir_entry >= LAST_VM_PDE) {
+			dir_entry = FIRST_VM_PDE;
+			if (++swap_task >= NR_TASKS)
+				swap_task = 0;
+		}
+	}
+/* the accessed bits we cleared must not stay cached in the TLB */
+	invalidate ();
+	swap_lock = 0;
+	wake_up (&swap_wait);
+	return freed;
+}
+
+/*
+ * Read the swap bitmap from SWAP_DEV. Called from sys_setup() once the
+ * partition tables are known.
+ */
+void
+init_swapping (void)
+{
+	int i, j;
+
+	if (!SWAP_DEV)
+		return;
+	if (!(swap_bitmap = (char *) get_free_page ())) {
+		printk ("Unable to get memory for swap bitmap\n\r");
+		return;
+	}
+	read_swap_page (0, swap_bitmap);
+	if (strncmp ("SWAP-SPACE", swap_bitmap + PAGE_SIZE - 10, 10)) {
+		printk ("Unable to find swap-space signature\n\r");
+		free_page ((unsigned long) swap_bitmap);
+		swap_bitmap = NULL;
+		return;
+	}
+	memset (swap_bitmap + PAGE_SIZE - 10, 0, 10);
+	if (bit (swap_bitmap, 0)) {
+		printk ("Bad swap-space bit-map\n\r");
+		free_page ((unsigned long) swap_bitmap);
+		swap_bitmap = NULL;
+		return;
+	}
+	for (i = j = 0; i < SWAP_BITS; i++)
+		if (bit (swap_bitmap, i)) {
+			swap_pages = i + 1;
+			j++;
+		}
+	if (!j) {
+		free_page ((unsigned long) swap_bitmap);
+		swap_bitmap = NULL;
+		return;
+	}
+	printk ("Swap device ok: %d pages (%d bytes) swap-space\n\r", j,
+		j * PAGE_SIZE);
+}